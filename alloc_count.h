@@ -0,0 +1,69 @@
+#ifndef ALLOC_COUNT_H
+#define ALLOC_COUNT_H
+
+// Allocation-counting test mode. Compiling a solver with -DCOUNT_ALLOCATIONS
+// replaces every form of the global operator new (plain, array, nothrow and
+// aligned) so that each heap allocation increments heap_allocations; the
+// solvers then report how many allocations happened in their steady-state
+// search loop (expected: 0). Include from one file only.
+#ifdef COUNT_ALLOCATIONS
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+std::atomic<long long> heap_allocations{0};
+
+// Counts the allocation and returns the block, or nullptr if the heap is exhausted.
+// Kept out of line, so the compiler does not pair a new-expression with the free()
+// of counted_release (which would trigger -Wmismatched-new-delete).
+__attribute__((noinline)) void *counted_allocate(std::size_t size, std::size_t alignment)
+{
+    ++heap_allocations;
+    if (size == 0)
+        size = 1;
+    if (alignment <= alignof(std::max_align_t))
+        return std::malloc(size);
+    // aligned_alloc needs a size that is a multiple of the alignment
+    return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+__attribute__((noinline)) void counted_release(void *p) noexcept
+{
+    std::free(p);
+}
+
+void *counted_allocate_or_throw(std::size_t size, std::size_t alignment)
+{
+    if (void *p = counted_allocate(size, alignment))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size) { return counted_allocate_or_throw(size, 0); }
+void *operator new[](std::size_t size) { return counted_allocate_or_throw(size, 0); }
+void *operator new(std::size_t size, std::align_val_t al) { return counted_allocate_or_throw(size, std::size_t(al)); }
+void *operator new[](std::size_t size, std::align_val_t al) { return counted_allocate_or_throw(size, std::size_t(al)); }
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept { return counted_allocate(size, 0); }
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept { return counted_allocate(size, 0); }
+void *operator new(std::size_t size, std::align_val_t al, const std::nothrow_t &) noexcept { return counted_allocate(size, std::size_t(al)); }
+void *operator new[](std::size_t size, std::align_val_t al, const std::nothrow_t &) noexcept { return counted_allocate(size, std::size_t(al)); }
+
+void operator delete(void *p) noexcept { counted_release(p); }
+void operator delete[](void *p) noexcept { counted_release(p); }
+void operator delete(void *p, std::size_t) noexcept { counted_release(p); }
+void operator delete[](void *p, std::size_t) noexcept { counted_release(p); }
+void operator delete(void *p, std::align_val_t) noexcept { counted_release(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { counted_release(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { counted_release(p); }
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept { counted_release(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { counted_release(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { counted_release(p); }
+void operator delete(void *p, std::align_val_t, const std::nothrow_t &) noexcept { counted_release(p); }
+void operator delete[](void *p, std::align_val_t, const std::nothrow_t &) noexcept { counted_release(p); }
+
+#endif
+
+#endif
@@ -1,24 +1,108 @@
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <assert.h>
-#include <map>
 #include <vector>
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 using namespace std;
 
 typedef pair<int, int> P;
-typedef map<P, int>    M;
 typedef pair<P, P>     PP;
 typedef vector<PP>     VPP;
-typedef vector<VPP>    VVPP;
+typedef vector<int>    VI;
 
-const PP UNDEF({-1, -1}, {-1, -1});
 
-ifstream in;
-int  W, L;
-M    n;
-VPP  sol;
-VVPP board;
+// Read-only memory mapping of a whole file.
+struct MappedFile {
+  const char* data = nullptr;
+  size_t      size = 0;
+  bool        ok   = false;
+
+  explicit MappedFile(const char* file) {
+    int fd = open(file, O_RDONLY);
+    if (fd < 0) return;
+    struct stat st;
+    if (fstat(fd, &st) == 0) {
+      size = st.st_size;
+      if (size == 0) ok = true;
+      else {
+        void* p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) { data = (const char*) p; ok = true; }
+      }
+    }
+    close(fd);
+  }
+
+  ~MappedFile() {
+    if (data != nullptr) munmap((void*) data, size);
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator = (const MappedFile&) = delete;
+};
+
+
+// Whitespace-separated token scanner over a mapped file.
+struct Scanner {
+  const char* p;
+  const char* end;
+
+  Scanner(const MappedFile& f) : p(f.data), end(f.data + f.size) { }
+
+  void skip_spaces() {
+    while (p < end and (*p == ' ' or *p == '\t' or *p == '\n' or *p == '\r')) ++p;
+  }
+
+  bool next_int(int& x) {
+    skip_spaces();
+    bool neg = false;
+    if (p < end and (*p == '-' or *p == '+')) neg = (*p++ == '-');
+    if (p == end or *p < '0' or *p > '9') return false;
+    x = 0;
+    while (p < end and '0' <= *p and *p <= '9') x = 10*x + (*p++ - '0');
+    if (neg) x = -x;
+    return true;
+  }
+
+  bool skip_token() {
+    skip_spaces();
+    if (p == end) return false;
+    while (p < end and not (*p == ' ' or *p == '\t' or *p == '\n' or *p == '\r')) ++p;
+    return true;
+  }
+};
+
+
+// Instance with a demand table indexed by the distinct (short side, long side)
+// pairs of the input, so its size does not depend on the side lengths.
+struct Instance {
+  int W = 0;
+  vector<P> dims;  // Distinct dimensions p x q (p <= q), sorted.
+  VI  n;           // n[i] = rectangles of dimensions dims[i] still to match.
+  VI  keys;        // Indices of dims in order of first appearance in the input.
+
+  // Index of d in dims, or -1 if no rectangle of the input has these dimensions.
+  int index(const P& d) const {
+    auto it = lower_bound(dims.begin(), dims.end(), d);
+    if (it == dims.end() or *it != d) return -1;
+    return it - dims.begin();
+  }
+};
+
+
+struct Output {
+  int L = 0;
+  VPP sol;
+};
 
 
 ostream& operator << (ostream& out, const P& z) {
@@ -27,30 +111,40 @@ ostream& operator << (ostream& out, const P& z) {
 }
 
 
-bool within_bounds(const P& point) {
+bool within_bounds(const P& point, int W, int L) {
   return
     0 <= point.first  and point.first  < W and
     0 <= point.second and point.second < L;
 }
 
 
-bool solution_ok() {
+// Checks the solution against the instance (whose demand table it consumes).
+// On failure, writes the reason to msg.
+bool solution_ok(Instance& inst, const Output& out, ostream& msg) {
 
-  board = VVPP(L, VPP(W, UNDEF));
+  int W = inst.W;
+  int L = out.L;
+  if (L < 0 or (long long) L * W > 1000000000LL) {
+    msg << "Error: invalid roll length L = " << L << endl;
+    return false;
+  }
+
+  // board[i*W + j] = 1 + index in sol of the rectangle covering (j, i), or 0 if free.
+  VI board((size_t) L * W, 0);
 
   int found_L = 0;
-  
-  for (auto tl_br : sol) {
 
-    P tl = tl_br.first;
-    if (not within_bounds(tl)) {
-      cout << "Error: position " << tl << " is out of bounds" << endl;
+  for (int k = 0; k < (int) out.sol.size(); ++k) {
+
+    P tl = out.sol[k].first;
+    if (not within_bounds(tl, W, L)) {
+      msg << "Error: position " << tl << " is out of bounds" << endl;
       return false;
     }
 
-    P br = tl_br.second;
-    if (not within_bounds(br)) {
-      cout << "Error: position " << br << " is out of bounds" << endl;
+    P br = out.sol[k].second;
+    if (not within_bounds(br, W, L)) {
+      msg << "Error: position " << br << " is out of bounds" << endl;
       return false;
     }
 
@@ -59,62 +153,61 @@ bool solution_ok() {
     int q = br.second - tl.second + 1;
 
     if (p <= 0 or q <= 0) {
-      cout << "Error: top-left corner "  << tl
-           << " and bottom-right corner " << br
-           << " do not define a valid rectangle" << endl;
+      msg << "Error: top-left corner "  << tl
+          << " and bottom-right corner " << br
+          << " do not define a valid rectangle" << endl;
       return false;
     }
 
     P d = (p <= q ? P(p, q) : P(q, p));
-    if (n.count(d) == 0) {
-      cout << "Error: rectangle of dimensions " << d.first << "x" << d.second
-           << " defined by top-left corner " << tl
-           << " and bottom-right corner "    << br
-           << " does not match any in input data" << endl;
+    int idx = inst.index(d);
+    if (idx < 0) {
+      msg << "Error: rectangle of dimensions " << d.first << "x" << d.second
+          << " defined by top-left corner " << tl
+          << " and bottom-right corner "    << br
+          << " does not match any in input data" << endl;
       return false;
     }
 
-    --n[d];
-
-    if (n[d] < 0) {
-      cout << "Error: too many rectangles of dimensions "
-           << d.first << "x" << d.second << endl;
+    if (--inst.n[idx] < 0) {
+      msg << "Error: too many rectangles of dimensions "
+          << d.first << "x" << d.second << endl;
       return false;
     }
 
     for (int i = tl.second; i <= br.second; ++i)
       for (int j = tl.first; j <= br.first; ++j) {
-	if (board[i][j] != UNDEF) {
-          P tl2 = board[i][j].first;
-          P br2 = board[i][j].second;
-	  cout << "Error:"
-	       << " rectangle defined by top-left corner "          << tl
-               << " and bottom-right corner "                       << br
-	       << " overlaps rectangle defined by top-left corner " << tl2
-               << " and bottom-right corner "                       << br2
-	       << " at position " << P(j, i) << endl;
+        int& cell = board[(size_t) i*W + j];
+        if (cell != 0) {
+          P tl2 = out.sol[cell - 1].first;
+          P br2 = out.sol[cell - 1].second;
+          msg << "Error:"
+              << " rectangle defined by top-left corner "          << tl
+              << " and bottom-right corner "                       << br
+              << " overlaps rectangle defined by top-left corner " << tl2
+              << " and bottom-right corner "                       << br2
+              << " at position " << P(j, i) << endl;
           return false;
         }
-	board[i][j] = {tl, br};
+        cell = k + 1;
       }
   }
 
   if (found_L != L) {
-    cout << "Error:"
-         << " Solution file indicates L = " << L
-         << " but the rectangles determine that L should be " << found_L << endl;
+    msg << "Error:"
+        << " Solution file indicates L = " << L
+        << " but the rectangles determine that L should be " << found_L << endl;
     return false;
   }
-  
-  for (auto di_ni : n) {
-    auto di = di_ni.first;
-    auto ni = di_ni.second;
+
+  for (int idx : inst.keys) {
+    int ni = inst.n[idx];
     if (ni > 0) {
-      cout << "Error: " << ni << " rectangle"
-           << (ni == 1 ? "" : "s")
-           << " of dimensions "
-           << di.first << "x" << di.second
-           << " missing" << endl;
+      msg << "Error: " << ni << " rectangle"
+          << (ni == 1 ? "" : "s")
+          << " of dimensions "
+          << inst.dims[idx].first << "x" << inst.dims[idx].second
+          << " missing" << endl;
       return false;
     }
   }
@@ -122,27 +215,133 @@ bool solution_ok() {
 }
 
 
-void read_instance(const char* file) {
-  ifstream in(file);
+// Lines with the same dimensions (in either orientation) add up their demand.
+bool read_instance(const char* file, Instance& inst, ostream& msg) {
+  MappedFile f(file);
+  if (not f.ok) {
+    msg << "Error: cannot open instance file " << file << endl;
+    return false;
+  }
+
+  Scanner in(f);
   int N;
-  in >> W >> N;
+  if (not in.next_int(inst.W) or not in.next_int(N)) {
+    msg << "Error: cannot parse instance file " << file << endl;
+    return false;
+  }
+
+  vector<pair<P, int>> lines;
   int ni, pi, qi;
-  while (N != 0) {
-    in >> ni >> pi >> qi;
+  while (N > 0 and in.next_int(ni) and in.next_int(pi) and in.next_int(qi)) {
     N -= ni;
-    n[{pi, qi}] = ni;
+    P d = (pi <= qi ? P(pi, qi) : P(qi, pi));
+    if (d.first <= 0) {
+      msg << "Error: invalid dimensions in instance file " << file << endl;
+      return false;
+    }
+    lines.push_back({d, ni});
+    inst.dims.push_back(d);
+  }
+
+  sort(inst.dims.begin(), inst.dims.end());
+  inst.dims.erase(unique(inst.dims.begin(), inst.dims.end()), inst.dims.end());
+  inst.n.assign(inst.dims.size(), 0);
+  vector<char> listed(inst.dims.size(), 0);
+  for (auto& l : lines) {
+    int idx = inst.index(l.first);
+    if (not listed[idx]) {
+      listed[idx] = 1;
+      inst.keys.push_back(idx);
+    }
+    inst.n[idx] += l.second;
   }
+  return true;
 }
 
 
-void read_solution(const char* file) {
-  ifstream in(file);
-  double time;
-  in >> time;
-  in >> L;
+bool read_solution(const char* file, Output& out, ostream& msg) {
+  MappedFile f(file);
+  if (not f.ok) {
+    msg << "Error: cannot open solution file " << file << endl;
+    return false;
+  }
+
+  Scanner in(f);
+  if (not in.skip_token() or not in.next_int(out.L)) {
+    msg << "Error: cannot parse solution file " << file << endl;
+    return false;
+  }
   int xtl, ytl, xbr, ybr;
-  while (in >> xtl >> ytl >> xbr >> ybr)
-    sol.push_back({{xtl, ytl}, {xbr, ybr}});
+  while (in.next_int(xtl) and in.next_int(ytl) and in.next_int(xbr) and in.next_int(ybr))
+    out.sol.push_back({{xtl, ytl}, {xbr, ybr}});
+  return true;
+}
+
+
+bool check(const char* instance_file, const char* solution_file, ostream& msg) {
+  Instance inst;
+  Output   out;
+  return
+    read_instance(instance_file, inst, msg) and
+    read_solution(solution_file, out,  msg) and
+    solution_ok(inst, out, msg);
+}
+
+
+// Validates every (instance, solution) pair listed in list_file (one pair per
+// line, "-" for stdin) on the given number of threads. Writes one line per pair,
+// in list order: "OK<TAB>instance<TAB>solution" or
+// "FAILED<TAB>instance<TAB>solution<TAB>reason". Returns the number of failures.
+int check_batch(const char* list_file, int threads) {
+  ifstream list_in;
+  istream* in = &cin;
+  if (strcmp(list_file, "-") != 0) {
+    list_in.open(list_file);
+    if (not list_in) {
+      cerr << "Error opening list file: " << list_file << endl;
+      exit(2);
+    }
+    in = &list_in;
+  }
+
+  vector<pair<string, string>> pairs;
+  string instance_file, solution_file;
+  while (*in >> instance_file >> solution_file)
+    pairs.push_back({instance_file, solution_file});
+
+  vector<string> verdict(pairs.size());
+  vector<char>   passed(pairs.size(), 0);
+  atomic<size_t> next(0);
+
+  auto worker = [&]() {
+    for (size_t i = next++; i < pairs.size(); i = next++) {
+      ostringstream msg;
+      passed[i] = check(pairs[i].first.c_str(), pairs[i].second.c_str(), msg);
+      string reason = msg.str();
+      if (not reason.empty() and reason.back() == '\n') reason.pop_back();
+      for (char& c : reason) if (c == '\n' or c == '\t') c = ' ';
+      verdict[i] = reason;
+    }
+  };
+
+  threads = max(1, min<int>(threads, pairs.size()));
+  vector<thread> pool;
+  for (int t = 1; t < threads; ++t) pool.emplace_back(worker);
+  worker();
+  for (auto& t : pool) t.join();
+
+  int failures = 0;
+  for (size_t i = 0; i < pairs.size(); ++i) {
+    cout << (passed[i] ? "OK" : "FAILED") << '\t'
+         << pairs[i].first << '\t' << pairs[i].second;
+    if (not passed[i]) {
+      cout << '\t' << verdict[i];
+      ++failures;
+    }
+    cout << '\n';
+  }
+  cout.flush();
+  return failures;
 }
 
 
@@ -152,14 +351,25 @@ int main(int argc, char** argv) {
   if (argc == 1) {
     cout << "Makes a sanity check of a solution" << endl;
     cout << "Usage: " << argv[0] << " INPUT_FILE OUTPUT_FILE" << endl;
+    cout << "       " << argv[0] << " --batch [-j THREADS] LIST_FILE" << endl;
+    cout << "LIST_FILE has one 'INPUT_FILE OUTPUT_FILE' pair per line ('-' reads stdin)." << endl;
+    cout << "Batch mode prints one tab-separated verdict per pair." << endl;
     exit(0);
   }
 
-  assert(argc == 3);
+  if (strcmp(argv[1], "--batch") == 0) {
+    int threads = max(1u, thread::hardware_concurrency());
+    int arg = 2;
+    if (arg + 1 < argc and strcmp(argv[arg], "-j") == 0) {
+      threads = max(1, atoi(argv[arg + 1]));
+      arg += 2;
+    }
+    assert(arg + 1 == argc);
+    exit(check_batch(argv[arg], threads) == 0 ? 0 : 1);
+  }
 
-  read_instance(argv[1]);
-  read_solution(argv[2]);
+  assert(argc == 3);
 
-  if (solution_ok()) {cout << "OK"     << endl; exit(0); }
-  else               {cout << "FAILED" << endl; exit(1); }
+  if (check(argv[1], argv[2], cout)) {cout << "OK"     << endl; exit(0); }
+  else                               {cout << "FAILED" << endl; exit(1); }
 }
@@ -1,4 +1,6 @@
 #include <iostream>
+#include <array>
+#include <atomic>
 #include <vector>
 #include <ctime>
 #include <climits>
@@ -8,6 +10,13 @@
 #include <iomanip>
 #include <csignal>
 
+#include "alloc_count.h"
+#include "exhaustive_search.h"
+#include "layout_cache.h"
+#include "lower_bound.h"
+#include "roll_grid.h"
+#include "solution_stack.h"
+
 using namespace std;
 
 struct Rectangle
@@ -20,19 +29,49 @@ struct Solution
     int x1, y1, x2, y2; // Coordinates of the rectangle (top-left and bottom-right)
 };
 
-// Initializer backtrack function so "try_place_rectangle" can be called recursively
-void backtrack(int index, int current_length, vector<vector<bool>> &grid, vector<Solution> &solution);
+// Incumbent layout with its length; two of them are kept and switched by index (see take_incumbent)
+struct Snapshot
+{
+    SolutionStack<Solution> placements; // Preallocated, so taking an incumbent never allocates
+    int length = INT_MAX;               // INT_MAX if there is no layout yet
+};
 
 // Global variables
 vector<Rectangle> rectangles;   // List of rectangles to place
-int W, best_length;             // Roll width and the best length found
-vector<Solution> best_solution; // Best solution (list of rectangle placements)
+int W;                          // Roll width
+Snapshot snapshots[2];          // Best solution found and the storage of the next one
+volatile sig_atomic_t current_snapshot = 0; // Index of the best solution, read by the signal handler
 clock_t start_time;             // Start time of the program
 string output_filename;         // Output file name (global for access in signal handler)
+int length_lower_bound = 0;     // LP lower bound on the roll length (see lower_bound.h)
+CachedLayout cached_layout;     // Layout of the same order found in the layout cache
+bool cache_hit = false;         // Whether cached_layout holds a layout
+
+// Search being run (see exhaustive_search.h), read by the signal handler
+const ExhaustiveFrontier *frontier = nullptr;
+
+// Checkpointing of the search frontier (see save_checkpoint)
+const double CHECKPOINT_INTERVAL = 30.0; // Seconds of search between two checkpoints
+string checkpoint_filename;     // Checkpoint file, empty if checkpointing is disabled
+double resumed_elapsed = 0;     // Search time spent by previous runs
+clock_t next_checkpoint;        // Clock value at which the next checkpoint is due
+
+// Best solution found (length INT_MAX if there is none)
+const Snapshot &incumbent()
+{
+    return snapshots[current_snapshot];
+}
+
+// Search time, including the runs resumed from a checkpoint
+double elapsed_seconds()
+{
+    return resumed_elapsed + double(clock() - start_time) / CLOCKS_PER_SEC;
+}
 
 // Function to write the current best solution to the output file.
 void write_solution()
 {
+    const Snapshot &best = incumbent();
     ofstream out_file_trunc(output_filename, ios::out | ios::trunc);
     if (!out_file_trunc)
     {
@@ -40,11 +79,10 @@ void write_solution()
         return;
     }
 
-    double elapsed = double(clock() - start_time) / CLOCKS_PER_SEC;
-    out_file_trunc << fixed << setprecision(1) << elapsed << endl;
-    out_file_trunc << best_length << endl;
+    out_file_trunc << fixed << setprecision(1) << elapsed_seconds() << endl;
+    out_file_trunc << best.length << endl;
 
-    for (const auto &sol : best_solution)
+    for (const auto &sol : best.placements)
     {
         out_file_trunc << sol.x1 << " " << sol.y1 << " "
                        << sol.x2 << " " << sol.y2 << endl;
@@ -53,147 +91,158 @@ void write_solution()
     out_file_trunc.close();
 }
 
-// Signal handler to catch interrupt signals
-void signal_handler(int signum)
-{
-    if (best_length < INT_MAX)
-    {
-        write_solution();
-    }
-    exit(signum);
-}
-
-// Check if a rectangle can be placed at position (x, y) in the grid.
-bool can_place(const vector<vector<bool>> &grid,
-               int x, int y,
-               int width, int height)
+// Saves the search frontier to the checkpoint file, if checkpointing is enabled. The
+// incumbent saved is the published snapshot, as the search may be writing its own.
+void write_checkpoint(bool finished)
 {
-    if (x + width > W || y + height > static_cast<int>(grid[0].size()))
-        return false;
+    if (checkpoint_filename.empty() || !frontier)
+        return;
 
-    for (int i = x; i < x + width; ++i)
-    {
-        for (int j = y; j < y + height; ++j)
-        {
-            if (grid[i][j])
-                return false;
-        }
-    }
-    return true;
+    const Snapshot &best = incumbent();
+    vector<array<int, 4>> placements;
+    for (const auto &sol : best.placements)
+        placements.push_back({sol.x1, sol.y1, sol.x2, sol.y2});
+    if (!save_checkpoint(checkpoint_filename, *frontier, best.length, placements, elapsed_seconds(), finished))
+        cerr << "Error writing checkpoint file: " << checkpoint_filename << endl;
 }
 
-// Marks or unmarks the cells in the grid occupied by the rectangle.
-void place_or_remove(vector<vector<bool>> &grid,
-                     int x, int y,
-                     int width, int height,
-                     bool action)
+// Dimensions of the rectangles, as used by the search, the lower bound and the layout cache
+vector<pair<int, int>> piece_dimensions()
 {
-    for (int i = x; i < x + width; ++i)
-    {
-        for (int j = y; j < y + height; ++j)
-        {
-            grid[i][j] = action;
-        }
-    }
+    vector<pair<int, int>> pieces;
+    for (const auto &r : rectangles)
+        pieces.emplace_back(r.width, r.height);
+    return pieces;
 }
 
-// Finds the lowest y-coordinate where the rectangle can be placed.
-int find_lowest_free_y(const vector<vector<bool>> &grid,
-                       int x, int width, int height,
-                       int current_length)
+// Makes the given layout the incumbent if it beats the current one. The layout and its
+// length are written to the inactive snapshot, and only then is current_snapshot switched
+// to it: the signal handler reads either the old incumbent or the new one, never a mix.
+void take_incumbent(int length, const vector<array<int, 4>> &placements)
 {
-    for (int y = 0; y <= current_length; ++y)
-    {
-        if (can_place(grid, x, y, width, height))
-            return y;
-    }
-    return -1; // No valid position found within current_length
+    if (length >= incumbent().length)
+        return;
+
+    Snapshot &next = snapshots[1 - current_snapshot];
+    next.placements.clear();
+    for (const auto &p : placements)
+        next.placements.push_back({p[0], p[1], p[2], p[3]});
+    next.length = length;
+    atomic_signal_fence(memory_order_release); // Keep the writes above before the switch
+    current_snapshot = 1 - current_snapshot;
 }
 
-// Helper function to attempt placing a rectangle and handle recursion
-void try_place_rectangle(int index,
-                         int x,
-                         int y,
-                         int width,
-                         int height,
-                         int new_length,
-                         vector<vector<bool>> &grid,
-                         vector<Solution> &solution)
+// Writes the incumbent back to the layout cache (kept only if it improves the entry).
+// Only a layout at the lower bound is marked proven: the search places every piece at the
+// lowest free y of each column, in area order, so finishing it does not prove optimality.
+void update_cache()
 {
-    // Place the rectangle on the grid
-    place_or_remove(grid, x, y, width, height, true);
-
-    // Add the rectangle's coordinates to the solution
-    solution.push_back({x, y, x + width - 1, y + height - 1});
-
-    backtrack(index + 1, new_length, grid, solution);
-
-    // Remove the rectangle from the grid
-    place_or_remove(grid, x, y, width, height, false);
+    const Snapshot &best = incumbent();
+    if (best.length == INT_MAX)
+        return;
 
-    // Remove the rectangle's coordinates from the solution
-    solution.pop_back();
+    CachedLayout layout;
+    layout.length = best.length;
+    layout.proven = best.length <= length_lower_bound;
+    for (const auto &sol : best.placements)
+        layout.placements.push_back({sol.x1, sol.y1, sol.x2, sol.y2});
+    store_cached_layout(W, piece_dimensions(), layout);
 }
 
-// Recursive backtrack function
-void backtrack(int index,
-               int current_length,
-               vector<vector<bool>> &grid,
-               vector<Solution> &solution)
+// Reports the search statistics and the optimality gap on stderr
+void report_statistics()
 {
-    // Prune branches that cannot yield a better solution
-    if (current_length >= best_length)
-        return;
+    cerr << "Nodes explored: " << (frontier ? frontier->nodes : 0) << endl;
+    cerr << "Lower bound: " << length_lower_bound;
+    if (incumbent().length < INT_MAX)
+        cerr << ", gap: " << fixed << setprecision(2) << optimality_gap(incumbent().length, length_lower_bound) << "%";
+    cerr << endl;
+}
 
-    // If all rectangles have been placed, update the best solution
-    if (index == static_cast<int>(rectangles.size()))
+// Signal handler to catch interrupt signals
+void signal_handler(int signum)
+{
+    if (incumbent().length < INT_MAX)
     {
-        best_length = current_length;
-        best_solution = solution;
-        return;
+        write_solution();
     }
+    write_checkpoint(false);
+    update_cache();
+    report_statistics();
+    exit(signum);
+}
 
-    // Get the current rectangle to place
-    Rectangle rect = rectangles[index];
-
-    // Iterate over all possible x-coordinates
-    for (int x = 0; x < W; ++x)
+// Runs the branch and bound of exhaustive_search.h, keeping every improved layout.
+// Grid is the occupancy grid type selected for the roll width (see roll_grid.h).
+template <typename Grid>
+void backtrack_init()
+{
+    // Static, so the signal handler and main can still read it once the search is over
+    static ExhaustiveSearch<Grid> search(W, piece_dimensions(), length_lower_bound);
+    frontier = &search;
+
+    // A cached layout of the same order is the starting upper bound; a checkpoint replaces
+    // it only with a shorter incumbent, so the shorter of the two is kept even for a
+    // search that already finished
+    if (cache_hit)
+        search.set_incumbent(cached_layout.length, cached_layout.placements);
+
+    // Resume a previous run of the same instance, if there is one
+    if (!checkpoint_filename.empty())
     {
-        // Attempt to place the rectangle in its original orientation
-        int y = find_lowest_free_y(grid, x, rect.width, rect.height, current_length);
-        if (y != -1)
+        switch (load_checkpoint(checkpoint_filename, search, resumed_elapsed))
         {
-            int new_length = max(current_length, y + rect.height);
-            try_place_rectangle(index, x, y, rect.width, rect.height, new_length, grid, solution);
+        case CheckpointLoad::NONE:
+            break;
+        case CheckpointLoad::MISMATCH:
+            cerr << "Error: checkpoint file " << checkpoint_filename << " does not match the input" << endl;
+            exit(1);
+        case CheckpointLoad::INVALID:
+            cerr << "Error parsing checkpoint file: " << checkpoint_filename << endl;
+            exit(1);
+        case CheckpointLoad::FINISHED:
+            cerr << "Search already finished in " << checkpoint_filename << endl;
+            take_incumbent(search.best_length, search.best);
+            return;
+        case CheckpointLoad::RESUMED:
+            cerr << "Resuming from " << checkpoint_filename << " at depth " << search.replay_depth() << endl;
+            break;
         }
+        next_checkpoint = clock() + static_cast<clock_t>(CHECKPOINT_INTERVAL * CLOCKS_PER_SEC);
+    }
+
+    take_incumbent(search.best_length, search.best);
+
+    // Periodically pause to save the search frontier (the clock is only read every 4096 nodes)
+    auto checkpoint_due = [&]()
+    {
+        return (search.nodes & 4095) == 0 && !checkpoint_filename.empty() && clock() >= next_checkpoint;
+    };
 
-        // If the rectangle is not a square, attempt to place it rotated
-        if (rect.width != rect.height)
+#ifdef COUNT_ALLOCATIONS
+    long long allocations_before = heap_allocations;
+#endif
+
+    for (;;)
+    {
+        auto status = search.run(checkpoint_due);
+        if (status == ExhaustiveSearch<Grid>::FINISHED)
+            break;
+        if (status == ExhaustiveSearch<Grid>::IMPROVED)
         {
-            int y_rotated = find_lowest_free_y(grid, x, rect.height, rect.width, current_length);
-            if (y_rotated != -1)
-            {
-                int new_length_rotated = max(current_length, y_rotated + rect.width);
-                try_place_rectangle(index, x, y_rotated, rect.height, rect.width, new_length_rotated, grid, solution);
-            }
+            take_incumbent(search.best_length, search.best);
+            continue;
         }
+        write_checkpoint(false);
+        next_checkpoint = clock() + static_cast<clock_t>(CHECKPOINT_INTERVAL * CLOCKS_PER_SEC);
     }
-}
-
-// Initializer backtrack function to set up the grid and solution
-void backtrack_init()
-{
-    // Compute an upper bound for grid height (sum of max dimensions of all rectangles)
-    int max_dim = 0;
-    for (const auto &r : rectangles)
-        max_dim += max(r.width, r.height);
 
-    // Initialize the grid with W columns and max_dim rows, all set to false (unoccupied)
-    vector<vector<bool>> grid(W, vector<bool>(max_dim, false));
+#ifdef COUNT_ALLOCATIONS
+    cerr << "Heap allocations during search: " << heap_allocations - allocations_before << endl;
+#endif
 
-    vector<Solution> solution;
-
-    backtrack(0, 0, grid, solution);
+    // Mark the search as finished, so later runs return the incumbent right away
+    write_checkpoint(true);
 }
 
 // Reads input from a file
@@ -206,8 +255,6 @@ void read_input_file(const string &filename)
         exit(1);
     }
 
-    best_length = INT_MAX; // Initialize best_length to a large value so the signal handler knows if a solution has been found
-
     int n;
     ifs >> W >> n;
 
@@ -250,21 +297,47 @@ int main(int argc, char *argv[])
 
     if (argc < 3)
     {
-        cerr << "Usage: " << argv[0] << " <input_file> <output_file>" << endl;
+        cerr << "Usage: " << argv[0] << " <input_file> <output_file> [checkpoint_file]" << endl;
         return 1;
     }
 
     // Store the output filename globally for access in write_solution and signal_handler
     output_filename = argv[2];
 
+    // With a checkpoint file, the search frontier is saved periodically and on interruption,
+    // and an existing checkpoint of the same instance is resumed
+    if (argc > 3)
+        checkpoint_filename = argv[3];
+
     read_input_file(argv[1]);
 
     // Sort rectangles by descending area (width * height)
     sort(rectangles.begin(), rectangles.end(), compare_rectangles);
 
-    // Start the backtracking process by calling the initializer backtrack function
-    backtrack_init();
+    // Preallocated placement stacks of the two snapshots
+    for (auto &snapshot : snapshots)
+        snapshot.placements.reset(rectangles.size());
+
+    // LP lower bound on the roll length, used to stop as soon as the incumbent is optimal
+    length_lower_bound = strip_lower_bound(W, piece_dimensions());
+
+    // An order already solved to optimality is answered from the layout cache
+    cache_hit = load_cached_layout(W, piece_dimensions(), cached_layout);
+    if (cache_hit && (cached_layout.proven || cached_layout.length <= length_lower_bound))
+    {
+        take_incumbent(cached_layout.length, cached_layout.placements);
+        write_solution();
+        cerr << "Proven layout found in the layout cache" << endl;
+        report_statistics();
+        return 0;
+    }
+
+    // Start the backtracking process with the fixed-width row masks of narrow rolls when W allows it
+    dispatch_on_width(W, [](auto grid_type)
+                      { backtrack_init<typename decltype(grid_type)::type>(); });
     write_solution();
+    update_cache();
+    report_statistics();
 
     return 0;
 }
@@ -0,0 +1,346 @@
+#ifndef EXHAUSTIVE_SEARCH_H
+#define EXHAUSTIVE_SEARCH_H
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "propagation.h"
+#include "roll_grid.h"
+
+// Branch and bound of exh, shared by exh and the solver API.
+//
+// Pieces are placed in the given order; every node places the next piece at
+// the lowest free y of each x, original orientation first, and prunes with
+// the incumbent, the lower bound and the propagation of propagation.h. The
+// search keeps its own stack instead of recursing, so run() can return to the
+// caller whenever the incumbent improves or the caller asks it to pause, and a
+// later run() continues exactly where it stopped. The choice being explored at
+// each depth is kept in path, which is what a checkpoint saves: a search
+// resumed from it replays the path and continues every loop from the saved
+// choice, so no part of the tree is lost. A checkpoint taken between nodes
+// (when run() pauses) explores nothing twice apart from the current node; one
+// taken from a signal handler may also repeat the subtree of the choice that
+// was just finished or just placed.
+//
+// The branching is not complete (fixed order, lowest position per column), so
+// finishing the search does not prove the incumbent optimal; only reaching the
+// lower bound does.
+
+struct Branch
+{
+    int x, rotated; // Choice being explored at one depth: x-coordinate and orientation
+};
+
+// State of the search that does not depend on the grid type, as saved in checkpoints
+struct ExhaustiveFrontier
+{
+    int W = 0;
+    std::vector<std::pair<int, int>> pieces;    // (width, height) in placement order
+    int lower_bound = 0;                        // The search stops once the incumbent reaches it
+    long long nodes = 0;                        // Search nodes entered
+    int best_length = INT_MAX;                  // Length of the incumbent, INT_MAX if there is none
+    std::vector<std::array<int, 4>> best;       // x1 y1 x2 y2 of every piece of the incumbent
+    std::vector<Branch> path;                   // path[d] is the choice being explored at depth d
+    int depth = 0;                              // Depth of the current node
+    bool entering = true;                       // The current node is entered next; otherwise its
+                                                // loop is running and path[depth] is its choice
+};
+
+template <typename Grid>
+class ExhaustiveSearch : public ExhaustiveFrontier
+{
+public:
+    enum Status
+    {
+        IMPROVED, // A shorter layout was found (best); run() again to continue
+        PAUSED,   // pause() returned true on entering a node; run() again to continue
+        FINISHED  // The tree is explored, or the incumbent reached the lower bound
+    };
+
+    ExhaustiveSearch(int roll_width, const std::vector<std::pair<int, int>> &placement_order, int length_lower_bound)
+        : grid(roll_width, max_roll_length(placement_order)),
+          propagator(roll_width, placement_order, grid.height)
+    {
+        W = roll_width;
+        pieces = placement_order;
+        lower_bound = length_lower_bound;
+        size_t n = pieces.size();
+        path.assign(n, Branch{0, 0});
+        frames.assign(n + 1, Frame{0, 0, 0, 0});
+        placed.reserve(n);
+        best.reserve(n);
+    }
+
+    // Makes a known layout (from a cache or a checkpoint) the incumbent if it is shorter
+    void set_incumbent(int length, const std::vector<std::array<int, 4>> &placements)
+    {
+        if (length >= best_length || placements.size() != pieces.size())
+            return;
+        best_length = length;
+        best = placements;
+    }
+
+    // Replays the first `saved_depth` choices of saved_path before searching (call before run)
+    void resume(const std::vector<Branch> &saved_path, int saved_depth)
+    {
+        resume_depth = std::min<int>(saved_depth, pieces.size());
+        std::copy(saved_path.begin(), saved_path.begin() + resume_depth, path.begin());
+    }
+
+    // Depths still to replay from the path restored by resume()
+    int replay_depth() const { return resume_depth; }
+
+    // Searches until the incumbent improves, pause() returns true or the search is over.
+    // pause() is called on entering every node, after the node is counted.
+    template <typename Pause>
+    Status run(Pause &&pause)
+    {
+        int n = static_cast<int>(pieces.size());
+        while (depth >= 0)
+        {
+            Frame &frame = frames[depth];
+            if (entering)
+            {
+                if (!counted)
+                {
+                    ++nodes;
+                    counted = true;
+                    if (pause())
+                        return PAUSED;
+                }
+                // Past the saved path the search is back to normal: the loop of this node starts
+                // from the first choice. This is set before the node stops entering, so a
+                // checkpoint never saves a stale path[depth].
+                if (depth >= resume_depth)
+                {
+                    resume_depth = 0;
+                    if (depth < n)
+                        path[depth] = Branch{0, 0};
+                }
+                entering = counted = false;
+
+                // Stop the whole search once the incumbent reaches the lower bound (it is optimal)
+                if (best_length <= lower_bound)
+                {
+                    depth = -1;
+                    break;
+                }
+
+                // Prune branches that cannot yield a better solution
+                if (frame.current_length >= best_length)
+                {
+                    --depth;
+                    continue;
+                }
+
+                // All pieces placed: a new incumbent, with its length published last so a
+                // checkpoint never pairs the new length with the old placements
+                if (depth == n)
+                {
+                    best.assign(placed.begin(), placed.end());
+                    best_length = frame.current_length;
+                    --depth;
+                    return IMPROVED;
+                }
+
+                // Prune dead subtrees before trying any placement
+                if (!propagator.feasible(depth, frame.current_length, grid, best_length))
+                {
+                    --depth;
+                    continue;
+                }
+
+                // When resuming, this depth's loop continues from the saved choice
+                frame.width = 0;
+            }
+            else if (frame.width != 0)
+            {
+                // Back from the subtree of the current choice: undo it and move to the next one
+                place_or_remove(grid, path[depth].x, frame.y, frame.width, frame.height, false);
+                placed.pop_back();
+                frame.width = 0;
+                next_choice(path[depth]);
+                resume_depth = 0; // The saved path is only replayed once
+            }
+
+            // Iterate over all possible x-coordinates, original orientation first
+            int w = pieces[depth].first, h = pieces[depth].second;
+            Branch &choice = path[depth];
+            bool found = false;
+            while (choice.x < W && !found)
+            {
+                // If the rectangle is a square, there is no rotated placement to try
+                if (!(choice.rotated && w == h))
+                {
+                    int width = choice.rotated ? h : w;
+                    int height = choice.rotated ? w : h;
+                    for (int y = 0; y <= frame.current_length; ++y)
+                    {
+                        if (can_place(grid, choice.x, y, width, height))
+                        {
+                            frame.y = y, frame.width = width, frame.height = height;
+                            found = true;
+                            break;
+                        }
+                    }
+                }
+                if (!found)
+                {
+                    next_choice(choice);
+                    resume_depth = 0;
+                }
+            }
+
+            if (!found)
+            {
+                --depth;
+                continue;
+            }
+
+            place_or_remove(grid, choice.x, frame.y, frame.width, frame.height, true);
+            placed.push_back({choice.x, frame.y, choice.x + frame.width - 1, frame.y + frame.height - 1});
+            frames[depth + 1].current_length = std::max(frame.current_length, frame.y + frame.height);
+            // Entering is set first: a checkpoint in between restarts this loop, while a
+            // child not yet entering would save its stale path entry
+            entering = true;
+            ++depth;
+        }
+        depth = -1;
+        return FINISHED;
+    }
+
+private:
+    struct Frame
+    {
+        int current_length;   // Roll length of the layout before the piece of this depth
+        int y, width, height; // Placement of the choice being explored (width == 0 if none)
+    };
+
+    static void next_choice(Branch &choice)
+    {
+        if (++choice.rotated == 2)
+            choice.rotated = 0, ++choice.x;
+    }
+
+    Grid grid;
+    Propagator propagator;
+    std::vector<Frame> frames;                  // frames[d] is the node where piece d is placed
+    std::vector<std::array<int, 4>> placed;     // Placements of the current partial layout
+    int resume_depth = 0;                       // Depths still to replay from path after a resume
+    bool counted = false;                       // The node being entered was already counted (paused on entry)
+};
+
+// Checkpoint files of the exhaustive search: the instance (to detect a mismatch on
+// resume), the run statistics, the incumbent and the branch path above the current
+// node, plus the choice of the current node when its loop is running. A depth of -1
+// marks a finished search. The file is written to a temporary name and renamed, so a
+// kill never leaves a truncated checkpoint behind. The incumbent is passed separately
+// so a signal handler can save the one it published rather than frontier.best, which
+// may be half written. Returns false if the file could not be written.
+inline bool save_checkpoint(const std::string &file, const ExhaustiveFrontier &frontier,
+                            int incumbent_length, const std::vector<std::array<int, 4>> &incumbent,
+                            double elapsed, bool finished)
+{
+    std::string tmp_file = file + ".tmp";
+    std::ofstream out(tmp_file, std::ios::out | std::ios::trunc);
+    if (!out)
+        return false;
+
+    out << "exh-checkpoint 1\n";
+    out << frontier.W << " " << frontier.pieces.size() << "\n";
+    for (const auto &p : frontier.pieces)
+        out << p.first << " " << p.second << "\n";
+
+    out << std::fixed << std::setprecision(1) << elapsed << " " << frontier.nodes << "\n";
+
+    bool has_incumbent = incumbent_length != INT_MAX;
+    out << incumbent_length << " " << (has_incumbent ? incumbent.size() : 0) << "\n";
+    for (size_t i = 0; has_incumbent && i < incumbent.size(); ++i)
+    {
+        const auto &p = incumbent[i];
+        out << p[0] << " " << p[1] << " " << p[2] << " " << p[3] << "\n";
+    }
+
+    // Number of choices to replay on resume: those above the current node, and its own
+    // choice once its loop is running (the resumed loop then continues from it)
+    int depth = frontier.depth;
+    if (finished || depth < 0)
+        depth = -1;
+    else if (!frontier.entering && depth < static_cast<int>(frontier.pieces.size()))
+        ++depth;
+    out << depth << "\n";
+    for (int d = 0; d < depth; ++d)
+        out << frontier.path[d].x << " " << frontier.path[d].rotated << "\n";
+
+    out.close();
+    return out && std::rename(tmp_file.c_str(), file.c_str()) == 0;
+}
+
+inline bool save_checkpoint(const std::string &file, const ExhaustiveFrontier &frontier, double elapsed, bool finished)
+{
+    return save_checkpoint(file, frontier, frontier.best_length, frontier.best, elapsed, finished);
+}
+
+enum class CheckpointLoad
+{
+    NONE,     // No checkpoint file: start from scratch
+    RESUMED,  // The search state was restored
+    FINISHED, // The saved search had already finished (its incumbent is restored)
+    MISMATCH, // The checkpoint belongs to another instance
+    INVALID   // The checkpoint could not be parsed
+};
+
+// Restores the state saved by save_checkpoint into a search that has not run yet
+template <typename Grid>
+CheckpointLoad load_checkpoint(const std::string &file, ExhaustiveSearch<Grid> &search, double &elapsed)
+{
+    std::ifstream in(file);
+    if (!in)
+        return CheckpointLoad::NONE;
+
+    std::string magic;
+    int version, w;
+    size_t n;
+    in >> magic >> version >> w >> n;
+    bool same_instance = in && magic == "exh-checkpoint" && version == 1 &&
+                         w == search.W && n == search.pieces.size();
+    for (size_t i = 0; same_instance && i < n; ++i)
+    {
+        int rw, rh;
+        in >> rw >> rh;
+        same_instance = in && rw == search.pieces[i].first && rh == search.pieces[i].second;
+    }
+    if (!same_instance)
+        return CheckpointLoad::MISMATCH;
+
+    int length;
+    size_t placed;
+    in >> elapsed >> search.nodes >> length >> placed;
+    std::vector<std::array<int, 4>> placements(std::min(placed, n));
+    for (auto &p : placements)
+        in >> p[0] >> p[1] >> p[2] >> p[3];
+
+    int depth;
+    in >> depth;
+    std::vector<Branch> path(std::max(0, std::min<int>(depth, n)));
+    for (auto &b : path)
+        in >> b.x >> b.rotated;
+
+    if (!in)
+        return CheckpointLoad::INVALID;
+
+    search.set_incumbent(length, placements);
+    if (depth < 0)
+        return CheckpointLoad::FINISHED;
+    search.resume(path, depth);
+    return CheckpointLoad::RESUMED;
+}
+
+#endif
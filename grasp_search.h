@@ -0,0 +1,113 @@
+#ifndef GRASP_SEARCH_H
+#define GRASP_SEARCH_H
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <random>
+#include <utility>
+#include <vector>
+
+// Randomised row construction of mh, shared by mh and the solver API.
+//
+// Every iteration shuffles the pieces and builds a layout row by row: a row is
+// opened by the first unplaced piece that fits the roll width (rotated first),
+// then filled left to right with the unplaced pieces that fit beside it, in
+// either orientation, within the height of the row. The shortest complete
+// layout is kept. Both layouts are reserved up front and swapped on an
+// improvement, so an iteration never allocates.
+
+struct GraspSearch
+{
+    struct Piece
+    {
+        int width, height;
+        bool placed;
+    };
+
+    int W;
+    std::vector<Piece> pieces;
+    std::mt19937 rng;
+    std::vector<std::array<int, 4>> candidate; // Layout being built (x1 y1 x2 y2 of every piece)
+    std::vector<std::array<int, 4>> best;      // Shortest layout built so far
+    int best_length = INT_MAX;                 // Length to beat
+
+    GraspSearch(int roll_width, const std::vector<std::pair<int, int>> &order, unsigned seed)
+        : W(roll_width), rng(seed)
+    {
+        for (const auto &p : order)
+            pieces.push_back({p.first, p.second, false});
+        candidate.reserve(pieces.size());
+        best.reserve(pieces.size());
+    }
+
+    // Makes a known layout (e.g. from the layout cache) the incumbent to beat
+    void set_incumbent(int length, const std::vector<std::array<int, 4>> &placements)
+    {
+        best_length = length;
+        best = placements;
+        best.reserve(pieces.size());
+    }
+
+    // Builds the layout of one random order. Returns true if it is shorter than the
+    // incumbent, which it then replaces in best.
+    bool iterate()
+    {
+        std::shuffle(pieces.begin(), pieces.end(), rng);
+        for (auto &p : pieces)
+            p.placed = false;
+        candidate.clear();
+
+        int roll_length = 0;
+        for (auto &big : pieces)
+        {
+            if (big.placed)
+                continue;
+
+            // Try the two orientations for the "big" piece
+            bool placed_big = false;
+            for (int rot = 0; rot < 2 && !placed_big; ++rot)
+            {
+                std::swap(big.width, big.height);
+                placed_big = big.width <= W;
+            }
+            if (!placed_big)
+                continue;
+
+            int y = roll_length;
+            int width_occupied = big.width, row_height = big.height;
+            candidate.push_back({0, y, big.width - 1, y + big.height - 1});
+            big.placed = true;
+            roll_length += big.height;
+
+            // Fill the leftover space of the row
+            for (auto &small : pieces)
+            {
+                if (small.placed || width_occupied == W)
+                    continue;
+
+                bool placed_small = false;
+                for (int rot = 0; rot < 2 && !placed_small; ++rot)
+                {
+                    std::swap(small.width, small.height);
+                    if (small.width <= W - width_occupied && small.height <= row_height)
+                    {
+                        candidate.push_back({width_occupied, y, width_occupied + small.width - 1, y + small.height - 1});
+                        small.placed = true;
+                        width_occupied += small.width;
+                        placed_small = true;
+                    }
+                }
+            }
+        }
+
+        if (roll_length >= best_length || candidate.size() != pieces.size())
+            return false;
+
+        best_length = roll_length;
+        std::swap(best, candidate);
+        return true;
+    }
+};
+
+#endif
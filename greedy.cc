@@ -1,63 +1,23 @@
 #include <iostream>
 #include <vector>
+#include <array>
 #include <ctime>
 #include <climits>
 #include <fstream>
 #include <sstream>
 #include <algorithm>
 #include <iomanip>
+#include <chrono>
+#include <thread>
 
-using namespace std;
-
-struct Rectangle
-{
-    int width, height; // Dimensions of the rectangle
-};
-
-struct Solution
-{
-    int x1, y1, x2, y2; // Coordinates of the rectangle (top-left and bottom-right)
-};
-
-// Function to check if a rectangle can be placed at position (x, y)
-bool can_place(const vector<vector<bool>> &grid, int x, int y, int W, int H)
-{
-    // Out of bounds check
-    if (x + W > (int)grid.size() || y + H > (int)grid[0].size())
-        return false;
-
-    // Check for overlapping with already placed rectangles
-    for (int i = x; i < x + W; ++i)
-    {
-        for (int j = y; j < y + H; ++j)
-        {
-            if (grid[i][j])
-                return false;
-        }
-    }
-    return true;
-}
-
-// Function to mark (action = True) or unmark (action = False) the grid when placing or removing a rectangle
-void place_or_remove(vector<vector<bool>> &grid, int x, int y, int W, int H, bool action)
-{
-    // Iterate over the rectangle's cells and mark/unmark them
-    for (int i = x; i < x + W; ++i)
-    {
-        for (int j = y; j < y + H; ++j)
-        {
-            grid[i][j] = action;
-        }
-    }
-}
+#include "greedy_placement.h"
+#include "layout_cache.h"
+#include "lower_bound.h"
+#include "roll_grid.h"
 
-// Comparator function to sort rectangles by descending area
-bool sort_rectangles(const Rectangle &a, const Rectangle &b)
-{
-    return (a.width * a.height) > (b.width * b.height);
-}
+using namespace std;
 
-void read_input_file(const string &filename, int &W, vector<Rectangle> &rectangles)
+void read_input_file(const string &filename, int &W, vector<pair<int, int>> &pieces)
 {
     ifstream input_file(filename);
     if (!input_file)
@@ -82,7 +42,7 @@ void read_input_file(const string &filename, int &W, vector<Rectangle> &rectangl
         {
             for (int i = 0; i < count; ++i)
             {
-                rectangles.emplace_back(Rectangle{rw, rh});
+                pieces.emplace_back(rw, rh);
             }
         }
         else
@@ -93,64 +53,11 @@ void read_input_file(const string &filename, int &W, vector<Rectangle> &rectangl
     input_file.close();
 }
 
-// Function to perform greedy placement of rectangles
-int do_greedy_placement(int W, const vector<Rectangle> &rectangles, vector<Solution> &solution)
-{
-    // Calculate maximum possible height
-    int max_dim = 0;
-    for (const auto &r : rectangles)
-        max_dim += max(r.width, r.height);
-
-    // Initialize grid with W columns and max_dim rows, all set to false (unoccupied)
-    vector<vector<bool>> grid(W, vector<bool>(max_dim, false));
-    int best_length = 0;
-
-    // Iterate through each rectangle
-    for (size_t i = 0; i < rectangles.size(); i++)
-    {
-        int rw = rectangles[i].width;
-        int rh = rectangles[i].height;
-        bool placed = false;
-
-        // Prioritize larger dimension as width and smaller as height
-        int w = max(rw, rh);
-        int h = min(rw, rh);
-
-        // Attempt to place the rectangle in both orientations
-        for (int y = 0; y < max_dim && !placed; y++)
-        {
-            for (int x = 0; x < W && !placed; x++)
-            {
-                // Try original orientation (w, h)
-                if (can_place(grid, x, y, w, h))
-                {
-                    place_or_remove(grid, x, y, w, h, true);
-                    solution.push_back(Solution{x, y, x + w - 1, y + h - 1});
-                    best_length = max(best_length, y + h);
-                    placed = true;
-                }
-                else
-                {
-                    // If rectangle is not a square, try the rotated orientation (h, w)
-                    if (rw != rh)
-                    {
-                        if (can_place(grid, x, y, h, w))
-                        {
-                            place_or_remove(grid, x, y, h, w, true);
-                            solution.push_back(Solution{x, y, x + h - 1, y + w - 1});
-                            best_length = max(best_length, y + w);
-                            placed = true;
-                        }
-                    }
-                }
-            }
-        }
-    }
-    return best_length;
-}
+// Wall-clock budget of the whole run (the greedy placement is kept if the beam search runs out of time)
+const double TIME_LIMIT = 4.5;
 
 // Function to output the solution to a file
-void output_solution(const string &filename, double elapsed_time, int best_length, const vector<Solution> &solution)
+void output_solution(const string &filename, double elapsed_time, int best_length, const vector<array<int, 4>> &solution)
 {
     ofstream outfile(filename);
     if (!outfile)
@@ -163,8 +70,8 @@ void output_solution(const string &filename, double elapsed_time, int best_lengt
     outfile << best_length << endl;
     for (const auto &sol : solution)
     {
-        outfile << sol.x1 << " " << sol.y1 << " "
-                << sol.x2 << " " << sol.y2 << endl;
+        outfile << sol[0] << " " << sol[1] << " "
+                << sol[2] << " " << sol[3] << endl;
     }
     outfile.close();
 }
@@ -174,28 +81,109 @@ int main(int argc, char *argv[])
     // Check for correct number of arguments
     if (argc < 3)
     {
-        cerr << "Usage: " << argv[0] << " <input_file> <output_file>" << endl;
+        cerr << "Usage: " << argv[0] << " <input_file> <output_file> [beam_width] [--portfolio]" << endl;
         return 1;
     }
 
-    // Start timing
-    clock_t start_time = clock();
+    // Start timing (wall clock, the beam search may use several threads)
+    auto start_time = chrono::steady_clock::now();
+    auto deadline = start_time + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(TIME_LIMIT));
+
+    // Beam width (0 runs the greedy placement only) and whether to run the rule portfolio
+    int beam_width = 0;
+    bool portfolio = false;
+    for (int i = 3; i < argc; i++)
+    {
+        if (string(argv[i]) == "--portfolio")
+            portfolio = true;
+        else
+            beam_width = atoi(argv[i]);
+    }
+    int threads = max(1u, thread::hardware_concurrency());
 
     int W;
-    vector<Rectangle> rectangles;
+    vector<pair<int, int>> pieces;
 
-    // Read and sort rectangles from the input file
-    read_input_file(argv[1], W, rectangles);
+    // Read and sort pieces from the input file
+    read_input_file(argv[1], W, pieces);
 
-    // Sort rectangles by descending area
-    sort(rectangles.begin(), rectangles.end(), sort_rectangles);
+    // Sort pieces by descending area
+    sort(pieces.begin(), pieces.end(), sort_by_area);
 
-    vector<Solution> solution;
-    int best_length = do_greedy_placement(W, rectangles, solution);
+    // Look the order up in the layout cache
+    CachedLayout cached;
+    bool cache_hit = load_cached_layout(W, pieces, cached);
+
+    vector<array<int, 4>> solution;
+    int best_length;
+    if (cache_hit && cached.proven)
+    {
+        // A proven layout of the same order is returned as is
+        best_length = cached.length;
+        solution = cached.placements;
+        cerr << "Proven layout found in the layout cache" << endl;
+    }
+    else
+    {
+        // LP lower bound for the optimality gap, computed first so that its time comes out of the
+        // budget of the portfolio and the beam (a short column generation, to stay in the time budget)
+        int length_lower_bound = StripLowerBound(W, pieces).solve(500);
+
+        // Placements other than the default greedy are dropped once the time budget is spent
+        auto past_deadline = [deadline]()
+        { return chrono::steady_clock::now() > deadline; };
+
+        // Use the fixed-width row masks of narrow rolls when W allows it; the portfolio
+        // includes the default rules, so it replaces the single greedy placement
+        best_length = dispatch_on_width(W, [&](auto grid_type)
+                                        {
+                                            using Grid = typename decltype(grid_type)::type;
+                                            if (portfolio)
+                                            {
+                                                int best_job;
+                                                int length = do_portfolio_placement<Grid>(W, pieces, solution, threads, past_deadline, best_job);
+                                                cerr << "Portfolio: best rule is " << SORT_RULES[best_job / PLACEMENT_RULES].name << " order, "
+                                                     << PLACEMENT_RULE_NAMES[best_job % PLACEMENT_RULES] << " placement" << endl;
+                                                return length;
+                                            }
+                                            Grid grid(W, max_roll_length(pieces));
+                                            return do_greedy_placement(grid, pieces, solution);
+                                        });
+
+        // The beam search result is kept only if it finishes in time and beats the greedy placement
+        if (beam_width > 0)
+        {
+            vector<array<int, 4>> beam_solution;
+            int beam_length = dispatch_on_width(W, [&](auto grid_type)
+                                                { return do_beam_placement<typename decltype(grid_type)::type>(W, pieces, beam_solution, beam_width, threads, best_length, past_deadline); });
+            if (beam_length != -1 && beam_length < best_length)
+            {
+                best_length = beam_length;
+                solution = beam_solution;
+            }
+        }
+
+        // The cached layout wins if it is at least as short; otherwise the new one is written back
+        if (cache_hit && cached.length <= best_length)
+        {
+            best_length = cached.length;
+            solution = cached.placements;
+        }
+        else
+        {
+            CachedLayout layout;
+            layout.length = best_length;
+            layout.proven = best_length <= length_lower_bound;
+            layout.placements = solution;
+            store_cached_layout(W, pieces, layout);
+        }
+
+        cerr << "Lower bound: " << length_lower_bound << ", gap: " << fixed << setprecision(2)
+             << optimality_gap(best_length, length_lower_bound) << "%" << endl;
+    }
 
     // End timing
-    clock_t end_time = clock();
-    double elapsed_time = double(end_time - start_time) / CLOCKS_PER_SEC;
+    double elapsed_time = chrono::duration<double>(chrono::steady_clock::now() - start_time).count();
 
     // Output the solution to the output file
     output_solution(argv[2], elapsed_time, best_length, solution);
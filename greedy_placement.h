@@ -0,0 +1,471 @@
+#ifndef GREEDY_PLACEMENT_H
+#define GREEDY_PLACEMENT_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "roll_grid.h"
+#include "solution_stack.h"
+
+// Placements of greedy, shared by greedy and the solver API.
+//
+// do_greedy_placement places the pieces one by one in the given order, with
+// one of the rules of PlacementRule; do_portfolio_placement runs it for every
+// combination of sort rule and placement rule on a pool of threads, and
+// do_beam_placement keeps the best partial layouts of the default order
+// instead of a single one. Pieces are (width, height) pairs and placements are
+// x1 y1 x2 y2 (inclusive corners). Every placement takes a should_stop
+// callable, checked once per piece (or beam state), so callers can impose a
+// deadline or a cancellation; it must be safe to call from several threads.
+
+// Default stop condition of the placements
+inline bool never_stop()
+{
+    return false;
+}
+
+// Comparator to sort pieces by descending area (the default order)
+inline bool sort_by_area(const std::pair<int, int> &a, const std::pair<int, int> &b)
+{
+    return (a.first * a.second) > (b.first * b.second);
+}
+
+// Alternative orderings tried by the portfolio: descending key, then descending area
+inline bool sort_by_height(const std::pair<int, int> &a, const std::pair<int, int> &b)
+{
+    return a.second != b.second ? a.second > b.second : sort_by_area(a, b);
+}
+
+inline bool sort_by_width(const std::pair<int, int> &a, const std::pair<int, int> &b)
+{
+    return a.first != b.first ? a.first > b.first : sort_by_area(a, b);
+}
+
+inline bool sort_by_perimeter(const std::pair<int, int> &a, const std::pair<int, int> &b)
+{
+    int pa = a.first + a.second, pb = b.first + b.second;
+    return pa != pb ? pa > pb : sort_by_area(a, b);
+}
+
+inline bool sort_by_max_side(const std::pair<int, int> &a, const std::pair<int, int> &b)
+{
+    int ma = std::max(a.first, a.second), mb = std::max(b.first, b.second);
+    return ma != mb ? ma > mb : sort_by_area(a, b);
+}
+
+struct SortRule
+{
+    const char *name;
+    bool (*compare)(const std::pair<int, int> &, const std::pair<int, int> &);
+};
+
+const SortRule SORT_RULES[] = {
+    {"area", sort_by_area},
+    {"height", sort_by_height},
+    {"width", sort_by_width},
+    {"perimeter", sort_by_perimeter},
+    {"max-side", sort_by_max_side},
+};
+
+// How do_greedy_placement chooses where each piece goes
+enum PlacementRule
+{
+    LONG_SIDE_HORIZONTAL,  // Lowest row, then leftmost column; long side horizontal on ties (default)
+    SHORT_SIDE_HORIZONTAL, // Lowest row, then leftmost column; short side horizontal on ties
+    MIN_LENGTH,            // Position and orientation giving the shortest roll, then the lowest bottom edge
+};
+
+const char *const PLACEMENT_RULE_NAMES[] = {"long-side-horizontal", "short-side-horizontal", "min-length"};
+
+// Portfolio jobs: job k uses sort rule k / PLACEMENT_RULES and placement rule k % PLACEMENT_RULES;
+// job 0 is the default greedy
+const int PLACEMENT_RULES = sizeof(PLACEMENT_RULE_NAMES) / sizeof(PLACEMENT_RULE_NAMES[0]);
+const int PORTFOLIO_JOBS = sizeof(SORT_RULES) / sizeof(SORT_RULES[0]) * PLACEMENT_RULES;
+
+// Function to perform greedy placement of pieces, in the given order and with the given rule.
+// Grid is the occupancy grid type selected for the roll width (see roll_grid.h); grid must be
+// W x max_roll_length(pieces) and is cleared first, so callers can reuse it.
+// Returns -1 if should_stop() returns true before all pieces are placed.
+template <typename Grid, typename Stop = bool (*)()>
+int do_greedy_placement(Grid &grid, const std::vector<std::pair<int, int>> &pieces,
+                        std::vector<std::array<int, 4>> &solution,
+                        PlacementRule rule = LONG_SIDE_HORIZONTAL, Stop should_stop = never_stop)
+{
+    int W = grid.width;
+    int max_dim = grid.height;
+    clear_grid(grid);
+    solution.clear();
+    int best_length = 0;
+    std::vector<int> lowest(W);
+
+    // Iterate through each piece
+    for (size_t i = 0; i < pieces.size(); i++)
+    {
+        if (should_stop())
+            return -1;
+
+        int rw = pieces[i].first;
+        int rh = pieces[i].second;
+
+        // Prioritize larger dimension as width and smaller as height (or the opposite)
+        int w = std::max(rw, rh);
+        int h = std::min(rw, rh);
+        if (rule == SHORT_SIDE_HORIZONTAL)
+            std::swap(w, h);
+
+        int best_x = -1, best_y = 0, best_w = w, best_h = h;
+        if (rule == MIN_LENGTH)
+        {
+            // Lowest position of every column, in both orientations
+            for (int rotated = 0; rotated < (rw != rh ? 2 : 1); rotated++)
+            {
+                int cw = rotated ? h : w;
+                int ch = rotated ? w : h;
+                lowest_fit_rows(grid, cw, ch, std::min(best_length, max_dim - ch), lowest.data());
+                for (int x = 0; x + cw <= W; x++)
+                {
+                    int y = lowest[x];
+                    if (y == -1)
+                        continue;
+                    bool better = best_x == -1 ||
+                                  std::max(best_length, y + ch) < std::max(best_length, best_y + best_h) ||
+                                  (std::max(best_length, y + ch) == std::max(best_length, best_y + best_h) &&
+                                   (y + ch < best_y + best_h || (y + ch == best_y + best_h && x < best_x)));
+                    if (better)
+                    {
+                        best_x = x, best_y = y, best_w = cw, best_h = ch;
+                    }
+                }
+            }
+        }
+        else
+        {
+            // Attempt to place the piece in both orientations, at the lowest row and then
+            // the leftmost column; at equal x the orientation (w, h) is preferred
+            for (int y = 0; y < max_dim && best_x == -1; y++)
+            {
+                int x = first_fit_x(grid, y, w, h);
+                int x_rotated = rw != rh ? first_fit_x(grid, y, h, w) : -1;
+
+                if (x != -1 && (x_rotated == -1 || x <= x_rotated))
+                {
+                    best_x = x, best_y = y;
+                }
+                else if (x_rotated != -1)
+                {
+                    // If the piece is not a square, use the rotated orientation (h, w)
+                    best_x = x_rotated, best_y = y, best_w = h, best_h = w;
+                }
+            }
+        }
+
+        if (best_x != -1)
+        {
+            place_or_remove(grid, best_x, best_y, best_w, best_h, true);
+            solution.push_back({best_x, best_y, best_x + best_w - 1, best_y + best_h - 1});
+            best_length = std::max(best_length, best_y + best_h);
+        }
+    }
+    return best_length;
+}
+
+// Runs portfolio job `job` (see PORTFOLIO_JOBS) on pieces sorted by descending area.
+// order is scratch space for the job's ordering.
+template <typename Grid, typename Stop = bool (*)()>
+int do_portfolio_job(Grid &grid, const std::vector<std::pair<int, int>> &pieces, int job,
+                     std::vector<std::pair<int, int>> &order, std::vector<std::array<int, 4>> &solution,
+                     Stop should_stop = never_stop)
+{
+    order = pieces;
+    std::stable_sort(order.begin(), order.end(), SORT_RULES[job / PLACEMENT_RULES].compare);
+    return do_greedy_placement(grid, order, solution, static_cast<PlacementRule>(job % PLACEMENT_RULES), should_stop);
+}
+
+// Runs every portfolio job on a pool of `threads` workers, each with its own grid, and keeps the
+// shortest roll (the first job on ties), whose index is stored in best_job. Job 0 is the default
+// greedy and always completes; the others are dropped if should_stop() returns true before they finish.
+template <typename Grid, typename Stop>
+int do_portfolio_placement(int W, const std::vector<std::pair<int, int>> &pieces, std::vector<std::array<int, 4>> &solution,
+                           int threads, Stop should_stop, int &best_job)
+{
+    std::vector<int> lengths(PORTFOLIO_JOBS, -1);
+    std::vector<std::vector<std::array<int, 4>>> solutions(PORTFOLIO_JOBS);
+    std::atomic<int> next(0);
+
+    auto worker = [&]()
+    {
+        Grid grid(W, max_roll_length(pieces));
+        std::vector<std::pair<int, int>> order;
+        for (int job = next++; job < PORTFOLIO_JOBS; job = next++)
+        {
+            if (job == 0)
+                lengths[job] = do_portfolio_job(grid, pieces, job, order, solutions[job]);
+            else
+                lengths[job] = do_portfolio_job(grid, pieces, job, order, solutions[job], should_stop);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int t = 1; t < std::min(threads, PORTFOLIO_JOBS); t++)
+        pool.emplace_back(worker);
+    worker();
+    for (auto &th : pool)
+        th.join();
+
+    best_job = 0;
+    for (int job = 1; job < PORTFOLIO_JOBS; job++)
+    {
+        if (lengths[job] != -1 && lengths[job] < lengths[best_job])
+            best_job = job;
+    }
+
+    solution = solutions[best_job];
+    return lengths[best_job];
+}
+
+// Partial layout kept in the beam
+template <typename Grid>
+struct BeamState
+{
+    Grid grid;
+    SolutionStack<std::array<int, 4>> placed;
+    std::vector<int> column_top; // Skyline: one past the lowest occupied row of each column
+    int length;                  // Roll length used so far
+    long long waste;             // Free cells under the skyline
+
+    BeamState(int W, int max_dim, size_t n) : grid(W, max_dim), placed(n), column_top(W, 0), length(0), waste(0) {}
+};
+
+// One placement of the next piece on top of a beam state
+struct Expansion
+{
+    int parent;        // Index of the expanded state in the beam
+    int x, y;          // Top-left corner
+    int width, height; // Placed orientation
+    int length;        // Roll length after the placement
+    long long waste;   // Free cells under the skyline after the placement
+};
+
+// Orders expansions by roll length, then by wasted area under the skyline, then
+// bottom-left (lowest top edge of the placed piece, then leftmost)
+inline bool better_expansion(const Expansion &a, const Expansion &b)
+{
+    if (a.length != b.length)
+        return a.length < b.length;
+    if (a.waste != b.waste)
+        return a.waste < b.waste;
+    if (a.y + a.height != b.y + b.height)
+        return a.y + a.height < b.y + b.height;
+    return a.x < b.x;
+}
+
+// Hash of the skyline left by an expansion, used to drop expansions that lead to the same profile
+inline unsigned long long skyline_hash(const std::vector<int> &column_top, const Expansion &e)
+{
+    unsigned long long hash = 1469598103934665603ULL; // FNV-1a
+    for (int c = 0; c < static_cast<int>(column_top.size()); c++)
+    {
+        int top = c >= e.x && c < e.x + e.width ? std::max(column_top[c], e.y + e.height) : column_top[c];
+        hash = (hash ^ static_cast<unsigned>(top)) * 1099511628211ULL;
+    }
+    return (hash ^ static_cast<unsigned long long>(e.waste)) * 1099511628211ULL;
+}
+
+// Fixed set of worker threads that run one step at a time: run(step) calls step(t) for every
+// t in [0, threads), t = 0 on the calling thread, and returns once all the calls are done.
+// The threads are started once, so a search with thousands of steps does not launch thousands of threads.
+class StepPool
+{
+public:
+    explicit StepPool(int threads)
+    {
+        for (int t = 1; t < threads; t++)
+            workers.emplace_back([this, t]()
+                                 { work(t); });
+    }
+
+    ~StepPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(guard);
+            stopping = true;
+            ++generation;
+        }
+        step_ready.notify_all();
+        for (auto &worker : workers)
+            worker.join();
+    }
+
+    void run(const std::function<void(int)> &step)
+    {
+        {
+            std::lock_guard<std::mutex> lock(guard);
+            current = &step;
+            pending = static_cast<int>(workers.size());
+            ++generation;
+        }
+        step_ready.notify_all();
+        step(0);
+
+        std::unique_lock<std::mutex> lock(guard);
+        step_done.wait(lock, [this]()
+                       { return pending == 0; });
+    }
+
+private:
+    void work(int t)
+    {
+        long long seen = 0;
+        for (;;)
+        {
+            const std::function<void(int)> *step;
+            {
+                std::unique_lock<std::mutex> lock(guard);
+                step_ready.wait(lock, [&]()
+                                { return generation != seen; });
+                seen = generation;
+                if (stopping)
+                    return;
+                step = current;
+            }
+            (*step)(t);
+
+            std::lock_guard<std::mutex> lock(guard);
+            if (--pending == 0)
+                step_done.notify_one();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex guard;
+    std::condition_variable step_ready, step_done;
+    const std::function<void(int)> *current = nullptr;
+    long long generation = 0; // Number of steps started (and one more once stopping)
+    int pending = 0;          // Workers still running the current step
+    bool stopping = false;
+};
+
+// Makes dst a copy of src; only the rows in use by either state are copied, since
+// the rows below a state's length are always empty
+template <typename Grid>
+void copy_state(BeamState<Grid> &dst, const BeamState<Grid> &src)
+{
+    copy_rows(dst.grid, src.grid, std::max(dst.length, src.length));
+    dst.placed.copy_from(src.placed);
+    std::copy(src.column_top.begin(), src.column_top.end(), dst.column_top.begin());
+    dst.length = src.length;
+    dst.waste = src.waste;
+}
+
+// Function to perform a beam search over the given placement order: the best beam_width
+// partial layouts are kept, and each one is expanded by every lowest placement (one per
+// x and orientation) of the next piece. Expansions are scored on `threads` threads.
+// Only layouts shorter than length_limit (the greedy length) are searched, which also
+// bounds the height of the grids. The states are allocated once and reused.
+// Returns -1 if no such layout is found or should_stop() returns true before the layout is complete.
+template <typename Grid, typename Stop>
+int do_beam_placement(int W, const std::vector<std::pair<int, int>> &pieces, std::vector<std::array<int, 4>> &solution,
+                      int beam_width, int threads, int length_limit, Stop should_stop)
+{
+    int max_dim = std::min(max_roll_length(pieces), length_limit - 1);
+    if (max_dim <= 0)
+        return -1;
+
+    size_t n = pieces.size();
+    std::vector<BeamState<Grid>> beam, next_beam;
+    for (int k = 0; k < beam_width; k++)
+    {
+        beam.emplace_back(W, max_dim, n);
+        next_beam.emplace_back(W, max_dim, n);
+    }
+    size_t beam_size = 1, next_size = 0;
+
+    std::vector<std::vector<Expansion>> expansions(threads);
+    std::vector<std::vector<int>> lowest(threads, std::vector<int>(W));
+    std::vector<Expansion> candidates;
+    std::unordered_set<unsigned long long> seen;
+    StepPool pool(threads);
+
+    for (size_t i = 0; i < n; i++)
+    {
+        if (should_stop())
+            return -1;
+
+        int rw = pieces[i].first;
+        int rh = pieces[i].second;
+
+        // Score every expansion of every state; thread t takes states t, t + threads, ...
+        pool.run([&](int t)
+                 {
+            expansions[t].clear();
+            for (size_t p = t; p < beam_size && !should_stop(); p += threads)
+            {
+                const BeamState<Grid> &state = beam[p];
+                for (int rotated = 0; rotated < (rw != rh ? 2 : 1); rotated++)
+                {
+                    int w = rotated ? rh : rw;
+                    int h = rotated ? rw : rh;
+                    lowest_fit_rows(state.grid, w, h, state.length, lowest[t].data());
+                    for (int x = 0; x + w <= W; x++)
+                    {
+                        int y = lowest[t][x];
+                        if (y == -1)
+                            continue;
+
+                        long long raised = 0;
+                        for (int c = x; c < x + w; c++)
+                            raised += std::max(state.column_top[c], y + h) - state.column_top[c];
+                        expansions[t].push_back(Expansion{static_cast<int>(p), x, y, w, h,
+                                                          std::max(state.length, y + h),
+                                                          state.waste + raised - static_cast<long long>(w) * h});
+                    }
+                }
+            } });
+
+        // A step cut short by should_stop has not scored every state
+        if (should_stop())
+            return -1;
+
+        candidates.clear();
+        for (const auto &e : expansions)
+            candidates.insert(candidates.end(), e.begin(), e.end());
+        if (candidates.empty())
+            return -1; // The piece does not fit in any state below length_limit
+
+        // Keep the best beam_width expansions with distinct skylines
+        std::sort(candidates.begin(), candidates.end(), better_expansion);
+        next_size = 0;
+        seen.clear();
+        for (size_t k = 0; k < candidates.size() && next_size < static_cast<size_t>(beam_width); k++)
+        {
+            const Expansion &e = candidates[k];
+            if (!seen.insert(skyline_hash(beam[e.parent].column_top, e)).second)
+                continue;
+
+            BeamState<Grid> &state = next_beam[next_size++];
+            copy_state(state, beam[e.parent]);
+            place_or_remove(state.grid, e.x, e.y, e.width, e.height, true);
+            state.placed.push_back({e.x, e.y, e.x + e.width - 1, e.y + e.height - 1});
+            for (int c = e.x; c < e.x + e.width; c++)
+                state.column_top[c] = std::max(state.column_top[c], e.y + e.height);
+            state.length = e.length;
+            state.waste = e.waste;
+        }
+        std::swap(beam, next_beam);
+        beam_size = next_size;
+    }
+
+    // States are sorted by length, so the first one is the best layout
+    solution.assign(beam[0].placed.begin(), beam[0].placed.end());
+    return beam[0].length;
+}
+
+#endif
@@ -0,0 +1,148 @@
+#ifndef LAYOUT_CACHE_H
+#define LAYOUT_CACHE_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <unistd.h>
+
+// On-disk cache of solved orders, shared by the solvers.
+//
+// An order is identified by its canonical key: the roll width and the sorted
+// multiset of piece dimensions, each normalised to (short side, long side), so
+// the same order listed in another sequence or with rotated pieces maps to the
+// same entry. Entries live in one file per order, named after the 64-bit
+// FNV-1a hash of the key; the key itself is stored in the file and checked on
+// load, so a hash collision is a miss rather than a wrong layout. Each entry
+// holds the best layout found, its length and whether it is proven optimal,
+// which the solvers only claim for a layout that reaches the lower bound.
+// Version 1 entries could also be marked proven by a finished exh run, which
+// is not a proof, so they are ignored.
+//
+// The cache directory is $TEXTILE_LAYOUT_CACHE, or .layout_cache in the
+// working directory; setting the variable to an empty string disables it.
+
+struct CachedLayout
+{
+    int length = 0;
+    bool proven = false;                      // Proven optimal (reaches the lower bound)
+    std::vector<std::array<int, 4>> placements; // x1 y1 x2 y2 of every rectangle
+};
+
+// Canonical key of an order; pieces holds the (width, height) of every rectangle
+inline std::string layout_cache_key(int W, const std::vector<std::pair<int, int>> &pieces)
+{
+    std::vector<std::pair<int, int>> normalised;
+    for (const auto &p : pieces)
+        normalised.emplace_back(std::min(p.first, p.second), std::max(p.first, p.second));
+    std::sort(normalised.begin(), normalised.end());
+
+    std::ostringstream key;
+    key << W;
+    for (const auto &p : normalised)
+        key << " " << p.first << "x" << p.second;
+    return key.str();
+}
+
+inline std::string layout_cache_directory()
+{
+    const char *dir = std::getenv("TEXTILE_LAYOUT_CACHE");
+    return dir ? dir : ".layout_cache";
+}
+
+// File holding the entry of a key, or an empty string if the cache is disabled
+inline std::string layout_cache_file(const std::string &key)
+{
+    std::string dir = layout_cache_directory();
+    if (dir.empty())
+        return "";
+
+    uint64_t hash = 1469598103934665603ULL; // FNV-1a
+    for (unsigned char c : key)
+        hash = (hash ^ c) * 1099511628211ULL;
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.layout", static_cast<unsigned long long>(hash));
+    return dir + "/" + name;
+}
+
+// Looks up an order; returns false on a miss
+inline bool load_cached_layout(int W, const std::vector<std::pair<int, int>> &pieces, CachedLayout &layout)
+{
+    std::string key = layout_cache_key(W, pieces);
+    std::string file = layout_cache_file(key);
+    if (file.empty())
+        return false;
+
+    std::ifstream in(file);
+    std::string magic, stored_key;
+    if (!in || !std::getline(in, magic) || magic != "textile-layout-cache 2" ||
+        !std::getline(in, stored_key) || stored_key != key)
+        return false;
+
+    size_t count;
+    int proven;
+    if (!(in >> layout.length >> proven >> count) || count != pieces.size())
+        return false;
+    layout.proven = proven != 0;
+    layout.placements.resize(count);
+    for (auto &p : layout.placements)
+        if (!(in >> p[0] >> p[1] >> p[2] >> p[3]))
+            return false;
+    return true;
+}
+
+// Temporary file to write an entry to before renaming it, unique to the writer: the pid
+// tells processes apart, and a process-wide counter tells apart the solves of one process
+// (the solver API can run several at once, for the same order)
+inline std::string layout_cache_temporary_file(const std::string &file)
+{
+    static std::atomic<unsigned long> writers{0};
+    return file + ".tmp" + std::to_string(getpid()) + "." + std::to_string(writers++);
+}
+
+// Stores a layout unless the cache already holds one that is at least as good
+// (shorter, or as short and already proven). Written to a temporary file and
+// renamed, so concurrent solvers never read a partial entry.
+inline void store_cached_layout(int W, const std::vector<std::pair<int, int>> &pieces, const CachedLayout &layout)
+{
+    std::string key = layout_cache_key(W, pieces);
+    std::string file = layout_cache_file(key);
+    if (file.empty() || layout.placements.size() != pieces.size())
+        return;
+
+    CachedLayout existing;
+    if (load_cached_layout(W, pieces, existing) &&
+        (existing.length < layout.length ||
+         (existing.length == layout.length && existing.proven >= layout.proven)))
+        return;
+
+    std::error_code error;
+    std::filesystem::create_directories(layout_cache_directory(), error);
+
+    std::string tmp_file = layout_cache_temporary_file(file);
+    {
+        std::ofstream out(tmp_file, std::ios::out | std::ios::trunc);
+        if (!out)
+            return;
+        out << "textile-layout-cache 2\n"
+            << key << "\n"
+            << layout.length << " " << (layout.proven ? 1 : 0) << " " << layout.placements.size() << "\n";
+        for (const auto &p : layout.placements)
+            out << p[0] << " " << p[1] << " " << p[2] << " " << p[3] << "\n";
+    }
+    std::filesystem::rename(tmp_file, file, error);
+    if (error)
+        std::filesystem::remove(tmp_file, error);
+}
+
+#endif
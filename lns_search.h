@@ -0,0 +1,204 @@
+#ifndef LNS_SEARCH_H
+#define LNS_SEARCH_H
+
+#include <algorithm>
+#include <array>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "propagation.h"
+#include "roll_grid.h"
+
+// Large-neighbourhood search of mh (--lns), shared by mh and the solver API.
+//
+// Each step removes the pieces of a horizontal band of the incumbent, either
+// around a random row or around the rows with the most waste (sampled in
+// proportion to it). The band is widened until no piece crosses its edges,
+// re-packed exactly by BandRepack, and the result is accepted only if it is
+// shorter: the pieces below the band then move up by the difference.
+
+const int LNS_MAX_BAND_PIECES = 16;     // Largest band that is re-packed
+const long long LNS_NODE_LIMIT = 50000; // Nodes of one exact re-pack
+const int LNS_MAX_FAILURES = 20000;     // Consecutive bands without improvement before giving up
+
+// Exact re-pack of the pieces of a band into the shortest strip of width W, with the
+// branching and the propagation of exh (lowest free y at every x, both orientations).
+// Grid is the occupancy grid type selected for the roll width (see roll_grid.h).
+template <typename Grid>
+struct BandRepack
+{
+    Grid grid;
+    const std::vector<std::pair<int, int>> &pieces; // (width, height), by descending area
+    Propagator propagator;
+    std::vector<std::array<int, 4>> current, best;  // x1 y1 x2 y2 of every piece
+    int best_height;                                // Height to beat
+    long long nodes = 0;
+
+    BandRepack(int W, int band_height, const std::vector<std::pair<int, int>> &band_pieces)
+        : grid(W, band_height), pieces(band_pieces), propagator(W, band_pieces, band_height),
+          best_height(band_height) {}
+
+    void search(int index, int height)
+    {
+        if (++nodes > LNS_NODE_LIMIT || height >= best_height)
+            return;
+
+        if (index == static_cast<int>(pieces.size()))
+        {
+            best_height = height;
+            best = current;
+            return;
+        }
+
+        if (!propagator.feasible(index, height, grid, best_height))
+            return;
+
+        int w = pieces[index].first, h = pieces[index].second;
+        for (int x = 0; x < grid.width; ++x)
+        {
+            for (int rotated = 0; rotated < (w != h ? 2 : 1); ++rotated)
+            {
+                int width = rotated ? h : w;
+                int height_placed = rotated ? w : h;
+
+                // Lowest free y, no higher than the current height and below the height to beat
+                for (int y = 0; y <= height && y + height_placed < best_height; ++y)
+                {
+                    if (!can_place(grid, x, y, width, height_placed))
+                        continue;
+
+                    place_or_remove(grid, x, y, width, height_placed, true);
+                    current.push_back({x, y, x + width - 1, y + height_placed - 1});
+                    search(index + 1, std::max(height, y + height_placed));
+                    current.pop_back();
+                    place_or_remove(grid, x, y, width, height_placed, false);
+                    break;
+                }
+            }
+        }
+    }
+};
+
+class LnsSearch
+{
+public:
+    std::vector<std::array<int, 4>> layout; // Incumbent, x1 y1 x2 y2 of every piece
+    int length;                             // Roll length of the incumbent
+    int failures = 0;                       // Consecutive steps without improvement
+
+    LnsSearch(int roll_width, const std::vector<std::array<int, 4>> &incumbent, int incumbent_length,
+              int length_lower_bound, unsigned seed)
+        : layout(incumbent), length(incumbent_length), W(roll_width), lower_bound(length_lower_bound), rng(seed)
+    {
+        for (const auto &p : layout)
+            longest_side = std::max({longest_side, p[2] - p[0] + 1, p[3] - p[1] + 1});
+    }
+
+    // No further step is worth taking: the incumbent is optimal or the search stalled
+    bool done() const { return failures >= LNS_MAX_FAILURES || length <= lower_bound; }
+
+    // Re-packs one band. Returns true if the incumbent got shorter.
+    bool step()
+    {
+        // Free cells of every row
+        row_waste.assign(length, W);
+        for (const auto &p : layout)
+            for (int y = p[1]; y <= p[3]; ++y)
+                row_waste[y] -= p[2] - p[0] + 1;
+
+        int centre;
+        long long total_waste = 0;
+        for (long long waste : row_waste)
+            total_waste += waste;
+        if (rng() % 2 == 0 || total_waste == 0)
+            centre = rng() % length;
+        else
+        {
+            long long pick = std::uniform_int_distribution<long long>(0, total_waste - 1)(rng);
+            for (centre = 0; pick >= row_waste[centre]; ++centre)
+                pick -= row_waste[centre];
+        }
+
+        // Band [top, bottom], widened until it is closed under the pieces crossing it
+        int reach = std::uniform_int_distribution<int>(0, longest_side)(rng);
+        int top = std::max(0, centre - reach), bottom = std::min(length - 1, centre + reach);
+        for (bool widened = true; widened;)
+        {
+            widened = false;
+            for (const auto &p : layout)
+            {
+                if (p[1] <= bottom && p[3] >= top && (p[1] < top || p[3] > bottom))
+                {
+                    top = std::min(top, p[1]);
+                    bottom = std::max(bottom, p[3]);
+                    widened = true;
+                }
+            }
+        }
+
+        band_pieces.clear();
+        long long band_area = 0;
+        for (const auto &p : layout)
+        {
+            if (p[1] >= top && p[3] <= bottom)
+            {
+                band_pieces.emplace_back(p[2] - p[0] + 1, p[3] - p[1] + 1);
+                band_area += static_cast<long long>(p[2] - p[0] + 1) * (p[3] - p[1] + 1);
+            }
+        }
+
+        // Too large for the exact search, or no shorter band can hold the area
+        int band_height = bottom - top + 1;
+        if (static_cast<int>(band_pieces.size()) > LNS_MAX_BAND_PIECES ||
+            band_area > static_cast<long long>(W) * (band_height - 1))
+        {
+            ++failures;
+            return false;
+        }
+
+        std::sort(band_pieces.begin(), band_pieces.end(), [](const std::pair<int, int> &a, const std::pair<int, int> &b)
+                  { return a.first * a.second > b.first * b.second; });
+
+        int new_height = dispatch_on_width(W, [&](auto grid_type)
+                                           {
+                                               BandRepack<typename decltype(grid_type)::type> repack(W, band_height, band_pieces);
+                                               repack.search(0, 0);
+                                               repacked.swap(repack.best);
+                                               return repack.best_height;
+                                           });
+        if (new_height >= band_height)
+        {
+            ++failures;
+            return false;
+        }
+
+        // Accept: replace the band and move the rest of the roll up
+        int shift = band_height - new_height;
+        next.clear();
+        for (const auto &p : layout)
+        {
+            if (p[1] > bottom)
+                next.push_back({p[0], p[1] - shift, p[2], p[3] - shift});
+            else if (p[3] < top)
+                next.push_back(p);
+        }
+        for (const auto &p : repacked)
+            next.push_back({p[0], p[1] + top, p[2], p[3] + top});
+        layout.swap(next);
+        length -= shift;
+        failures = 0;
+        return true;
+    }
+
+private:
+    int W;
+    int lower_bound;
+    std::mt19937 rng;
+    int longest_side = 0;
+    std::vector<long long> row_waste;            // Scratch: free cells of every row
+    std::vector<std::pair<int, int>> band_pieces; // Scratch: pieces of the band
+    std::vector<std::array<int, 4>> repacked, next;
+};
+
+#endif
@@ -0,0 +1,320 @@
+#ifndef LOWER_BOUND_H
+#define LOWER_BOUND_H
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <map>
+#include <utility>
+#include <vector>
+
+// Lower bound on the roll length from the LP relaxation of the strip, solved by
+// column generation.
+//
+// Any layout can be cut into rows of height 1; the rectangles crossed by a row
+// form a pattern whose widths add up to at most W, and a rectangle placed with
+// width w and height h crosses h rows. Writing x_p for the number of rows cut
+// with pattern p, every layout satisfies
+//
+//     minimise  sum_p x_p
+//     s.t.      sum_p (sum_o a_iop / h_io) x_p >= d_i   for every piece type i
+//               x_p >= 0
+//
+// where a_iop counts the pieces of type i in orientation o in pattern p, h_io
+// is their height and d_i the demand. The LP is solved with a dense revised
+// simplex; pattern columns are priced with a bounded knapsack over the piece
+// widths against W. The bound returned is Farley's bound d.pi / max_p(pi.a_p),
+// which is valid at every iteration, so an early stop still gives a bound.
+
+struct StripLowerBound
+{
+    struct Orientation
+    {
+        int width, height;
+    };
+
+    struct PieceType
+    {
+        int demand;
+        std::vector<Orientation> orientations; // Orientations no wider than W
+    };
+
+    int W;
+    std::vector<PieceType> types;
+    std::vector<std::vector<double>> basis_columns; // Column of each basic variable (pattern or surplus)
+    std::vector<double> basis_costs;                // 1 for patterns, 0 for surplus variables
+    std::vector<std::vector<double>> inverse;       // Inverse of the basis matrix
+    std::vector<double> values;                     // Values of the basic variables
+
+    static constexpr double EPS = 1e-9;
+
+    // pieces holds the (width, height) of every rectangle to cut
+    StripLowerBound(int roll_width, const std::vector<std::pair<int, int>> &pieces) : W(roll_width)
+    {
+        std::map<std::pair<int, int>, int> demand;
+        for (const auto &p : pieces)
+            ++demand[{std::min(p.first, p.second), std::max(p.first, p.second)}];
+
+        for (const auto &entry : demand)
+        {
+            PieceType type{entry.second, {}};
+            int a = entry.first.first, b = entry.first.second;
+            if (b <= W)
+                type.orientations.push_back({b, a});
+            if (a <= W && a != b)
+                type.orientations.push_back({a, b});
+            types.push_back(type);
+        }
+    }
+
+    // Pattern column: coverage of each piece type by the given counts per (type, orientation)
+    std::vector<double> column(const std::vector<std::vector<int>> &counts) const
+    {
+        std::vector<double> col(types.size(), 0.0);
+        for (size_t i = 0; i < types.size(); ++i)
+            for (size_t o = 0; o < types[i].orientations.size(); ++o)
+                col[i] += double(counts[i][o]) / types[i].orientations[o].height;
+        return col;
+    }
+
+    // Pricing: the pattern maximising sum_i pi_i * col_i, as counts per (type, orientation).
+    // Bounded knapsack over the widths, at most d_i pieces of type i per pattern.
+    double price(const std::vector<double> &pi, std::vector<std::vector<int>> &counts) const
+    {
+        struct Item
+        {
+            int type, orientation, width;
+            double value;
+        };
+        std::vector<Item> items; // One item per copy of a piece that could share a row
+        for (size_t i = 0; i < types.size(); ++i)
+        {
+            if (pi[i] <= EPS || types[i].orientations.empty())
+                continue;
+            int narrowest = W;
+            for (const auto &o : types[i].orientations)
+                narrowest = std::min(narrowest, o.width);
+            int copies = std::min(types[i].demand, W / narrowest);
+            for (int c = 0; c < copies; ++c)
+                for (size_t o = 0; o < types[i].orientations.size(); ++o)
+                    items.push_back({int(i), int(o), types[i].orientations[o].width,
+                                     pi[i] / types[i].orientations[o].height});
+        }
+
+        // Each copy chooses one orientation or none (a multiple-choice knapsack over groups of
+        // consecutive items); best[] is updated in place from the highest capacity down
+        std::vector<double> best(W + 1, 0.0);
+        std::vector<int> choice; // choice[g * (W + 1) + w] = item taken by group g at capacity w, or -1
+        int groups = 0;
+        for (size_t k = 0; k < items.size(); ++groups)
+        {
+            size_t end = k + 1;
+            while (end < items.size() && items[end].type == items[k].type &&
+                   items[end].orientation > items[end - 1].orientation)
+                ++end;
+
+            choice.resize(choice.size() + W + 1, -1);
+            int *taken = &choice[choice.size() - (W + 1)];
+            for (int w = W; w > 0; --w)
+                for (size_t it = k; it < end; ++it)
+                    if (items[it].width <= w && best[w - items[it].width] + items[it].value > best[w] + EPS)
+                    {
+                        best[w] = best[w - items[it].width] + items[it].value;
+                        taken[w] = int(it);
+                    }
+            k = end;
+        }
+
+        counts.assign(types.size(), std::vector<int>(2, 0));
+        int w = W;
+        for (int g = groups - 1; g >= 0; --g)
+        {
+            int it = choice[g * (W + 1) + w];
+            if (it < 0)
+                continue;
+            ++counts[items[it].type][items[it].orientation];
+            w -= items[it].width;
+        }
+        return best[W];
+    }
+
+    // Recomputes the basis inverse by Gauss-Jordan elimination (for numerical stability)
+    bool refactor()
+    {
+        size_t n = types.size();
+        std::vector<std::vector<double>> a(n, std::vector<double>(2 * n, 0.0));
+        for (size_t r = 0; r < n; ++r)
+        {
+            for (size_t c = 0; c < n; ++c)
+                a[r][c] = basis_columns[c][r];
+            a[r][n + r] = 1.0;
+        }
+        for (size_t c = 0; c < n; ++c)
+        {
+            size_t pivot = c;
+            for (size_t r = c + 1; r < n; ++r)
+                if (std::fabs(a[r][c]) > std::fabs(a[pivot][c]))
+                    pivot = r;
+            if (std::fabs(a[pivot][c]) < EPS)
+                return false;
+            std::swap(a[pivot], a[c]);
+            double inv = 1.0 / a[c][c];
+            for (auto &v : a[c])
+                v *= inv;
+            for (size_t r = 0; r < n; ++r)
+                if (r != c && a[r][c] != 0.0)
+                {
+                    double f = a[r][c];
+                    for (size_t k = 0; k < 2 * n; ++k)
+                        a[r][k] -= f * a[c][k];
+                }
+        }
+        for (size_t r = 0; r < n; ++r)
+            inverse[r].assign(a[r].begin() + n, a[r].end());
+        return true;
+    }
+
+    // Runs column generation for at most max_iterations pivots and returns the
+    // lower bound on the roll length (0 if there is nothing to place, INT_MAX if
+    // some piece is wider than the roll in both orientations).
+    int solve(int max_iterations = 5000)
+    {
+        size_t n = types.size();
+        if (n == 0)
+            return 0;
+
+        // Trivial bounds: every piece needs its length in some orientation, and the area
+        long long area = 0;
+        int tallest = 0;
+        for (const auto &t : types)
+        {
+            if (t.orientations.empty())
+                return INT_MAX;
+            int shortest = INT_MAX;
+            for (const auto &o : t.orientations)
+                shortest = std::min(shortest, o.height);
+            const Orientation &o = t.orientations[0];
+            area += static_cast<long long>(o.width) * o.height * t.demand;
+            tallest = std::max(tallest, shortest);
+        }
+        int trivial = std::max<long long>(tallest, (area + W - 1) / W);
+
+        // Initial basis: for each type, the pattern repeating it as often as a row allows
+        basis_columns.assign(n, std::vector<double>(n, 0.0));
+        basis_costs.assign(n, 1.0);
+        inverse.assign(n, std::vector<double>(n, 0.0));
+        values.assign(n, 0.0);
+        for (size_t i = 0; i < n; ++i)
+        {
+            const Orientation &o = types[i].orientations[0];
+            int copies = std::min(types[i].demand, W / o.width);
+            basis_columns[i][i] = double(copies) / o.height;
+            inverse[i][i] = 1.0 / basis_columns[i][i];
+            values[i] = types[i].demand * inverse[i][i];
+        }
+
+        double bound = 0.0;
+        std::vector<double> pi(n), clipped(n), direction(n);
+        std::vector<std::vector<int>> counts;
+        for (int iteration = 0; iteration < max_iterations; ++iteration)
+        {
+            if (iteration % 100 == 99 && !refactor())
+                break;
+
+            // Duals: pi = c_B B^-1
+            for (size_t c = 0; c < n; ++c)
+            {
+                pi[c] = 0.0;
+                for (size_t r = 0; r < n; ++r)
+                    pi[c] += basis_costs[r] * inverse[r][c];
+            }
+
+            // Farley's bound with the non-negative part of pi
+            double objective = 0.0;
+            for (size_t i = 0; i < n; ++i)
+            {
+                clipped[i] = std::max(0.0, pi[i]);
+                objective += types[i].demand * clipped[i];
+            }
+            double best_value = price(clipped, counts);
+            if (best_value > EPS)
+                bound = std::max(bound, objective / std::max(1.0, best_value));
+
+            // The roll length is an integer: once the bound rounds up to the master's value
+            // (an upper bound on the LP optimum), more columns cannot improve it
+            double master = 0.0;
+            for (size_t r = 0; r < n; ++r)
+                master += basis_costs[r] * values[r];
+            if (std::ceil(bound - 1e-6) >= std::ceil(master - 1e-6))
+                break;
+
+            // Entering column: a surplus variable with negative reduced cost, else the priced pattern
+            std::vector<double> entering(n, 0.0);
+            double entering_cost;
+            size_t surplus = n;
+            for (size_t i = 0; i < n && surplus == n; ++i)
+                if (pi[i] < -EPS)
+                    surplus = i;
+            if (surplus < n)
+            {
+                entering[surplus] = -1.0;
+                entering_cost = 0.0;
+            }
+            else if (best_value > 1.0 + 1e-7)
+            {
+                entering = column(counts);
+                entering_cost = 1.0;
+            }
+            else
+                break; // Optimal: the bound equals the LP value
+
+            // Ratio test on B^-1 a
+            size_t leaving = n;
+            for (size_t r = 0; r < n; ++r)
+            {
+                direction[r] = 0.0;
+                for (size_t c = 0; c < n; ++c)
+                    direction[r] += inverse[r][c] * entering[c];
+                if (direction[r] > EPS &&
+                    (leaving == n || values[r] / direction[r] < values[leaving] / direction[leaving]))
+                    leaving = r;
+            }
+            if (leaving == n)
+                break;
+
+            // Pivot
+            double step = values[leaving] / direction[leaving];
+            for (size_t r = 0; r < n; ++r)
+                values[r] -= step * direction[r];
+            values[leaving] = step;
+            double inv = 1.0 / direction[leaving];
+            for (auto &v : inverse[leaving])
+                v *= inv;
+            for (size_t r = 0; r < n; ++r)
+                if (r != leaving && direction[r] != 0.0)
+                    for (size_t c = 0; c < n; ++c)
+                        inverse[r][c] -= direction[r] * inverse[leaving][c];
+            basis_columns[leaving] = entering;
+            basis_costs[leaving] = entering_cost;
+        }
+
+        return std::max(trivial, static_cast<int>(std::ceil(bound - 1e-6)));
+    }
+};
+
+// Convenience wrapper: LP lower bound on the roll length for the given pieces
+inline int strip_lower_bound(int W, const std::vector<std::pair<int, int>> &pieces)
+{
+    StripLowerBound lb(W, pieces);
+    return lb.solve();
+}
+
+// Optimality gap of a roll length with respect to a lower bound, in percent
+inline double optimality_gap(int length, int lower_bound)
+{
+    if (length <= 0 || lower_bound <= 0 || lower_bound == INT_MAX)
+        return 0.0;
+    return 100.0 * (length - lower_bound) / length;
+}
+
+#endif
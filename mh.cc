@@ -1,4 +1,6 @@
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <climits>
 #include <csignal>
@@ -10,13 +12,19 @@
 #include <vector>
 #include <ctime>
 
+#include "alloc_count.h"
+#include "grasp_search.h"
+#include "layout_cache.h"
+#include "lns_search.h"
+#include "lower_bound.h"
+#include "solution_stack.h"
+
 using namespace std;
 
 struct Rectangle
 {
     int width;
     int height;
-    bool placed;
 };
 
 struct Solution
@@ -24,17 +32,33 @@ struct Solution
     int x1, y1, x2, y2;
 };
 
+// Incumbent layout with its length; two of them are kept and switched by index (see take_incumbent)
+struct Snapshot
+{
+    SolutionStack<Solution> placements; // Preallocated, so taking an incumbent never allocates
+    int length = INT_MAX;               // INT_MAX if there is no layout yet
+};
+
 clock_t start_time;
 string output_filename;
 vector<Rectangle> rectangles;
-vector<Solution> best_solution;
 
-// Global so the signal handler can easily access it
-int best_length = INT_MAX;
+// Global so the signal handler can easily access them
+Snapshot snapshots[2];                      // Best solution found and the storage of the next one
+volatile sig_atomic_t current_snapshot = 0; // Index of the best solution
+int length_lower_bound = 0; // LP lower bound on the roll length (see lower_bound.h)
+int roll_width;             // W, kept for the layout cache write-back in the signal handler
+
+// Best solution found (length INT_MAX if there is none)
+const Snapshot &incumbent()
+{
+    return snapshots[current_snapshot];
+}
 
 // Function to write the current best solution to the output file.
 void write_solution()
 {
+    const Snapshot &best = incumbent();
     ofstream out_file_trunc(output_filename, ios::out | ios::trunc);
     if (!out_file_trunc)
     {
@@ -44,9 +68,9 @@ void write_solution()
 
     double elapsed = double(clock() - start_time) / CLOCKS_PER_SEC;
     out_file_trunc << fixed << setprecision(1) << elapsed << endl;
-    out_file_trunc << best_length << endl;
+    out_file_trunc << best.length << endl;
 
-    for (const auto &sol : best_solution)
+    for (const auto &sol : best.placements)
     {
         out_file_trunc << sol.x1 << " " << sol.y1 << " "
                        << sol.x2 << " " << sol.y2 << endl;
@@ -54,13 +78,69 @@ void write_solution()
     out_file_trunc.close();
 }
 
+// Reports the optimality gap against the lower bound on stderr
+void report_gap()
+{
+    cerr << "Lower bound: " << length_lower_bound;
+    if (incumbent().length < INT_MAX)
+        cerr << ", gap: " << fixed << setprecision(2) << optimality_gap(incumbent().length, length_lower_bound) << "%";
+    cerr << endl;
+}
+
+// Dimensions of the rectangles, as used by the lower bound and the layout cache
+vector<pair<int, int>> piece_dimensions()
+{
+    vector<pair<int, int>> pieces;
+    for (const auto &r : rectangles)
+        pieces.emplace_back(r.width, r.height);
+    return pieces;
+}
+
+// Placements of the incumbent, as used by the searches and the layout cache
+vector<array<int, 4>> incumbent_placements()
+{
+    vector<array<int, 4>> placements;
+    for (const auto &sol : incumbent().placements)
+        placements.push_back({sol.x1, sol.y1, sol.x2, sol.y2});
+    return placements;
+}
+
+// Makes a layout found by a search the incumbent. The layout and its length are written
+// to the inactive snapshot, and only then is current_snapshot switched to it: the signal
+// handler reads either the old incumbent or the new one, never a mix.
+void take_incumbent(int length, const vector<array<int, 4>> &placements)
+{
+    Snapshot &next = snapshots[1 - current_snapshot];
+    next.placements.clear();
+    for (const auto &p : placements)
+        next.placements.push_back({p[0], p[1], p[2], p[3]});
+    next.length = length;
+    atomic_signal_fence(memory_order_release); // Keep the writes above before the switch
+    current_snapshot = 1 - current_snapshot;
+}
+
+// Writes the incumbent back to the layout cache (kept only if it improves the entry)
+void update_cache()
+{
+    if (incumbent().length == INT_MAX)
+        return;
+
+    CachedLayout layout;
+    layout.length = incumbent().length;
+    layout.proven = layout.length <= length_lower_bound;
+    layout.placements = incumbent_placements();
+    store_cached_layout(roll_width, piece_dimensions(), layout);
+}
+
 // Signal handler to catch interrupt signals
 void signal_handler(int signum)
 {
-    if (best_length < INT_MAX)
+    if (incumbent().length < INT_MAX)
     {
         write_solution();
     }
+    update_cache();
+    report_gap();
     exit(signum);
 }
 
@@ -74,7 +154,6 @@ int read_input_file(const string &filename)
         exit(1);
     }
 
-    best_length = INT_MAX; // Initialize best_length to a large value so the signal handler knows if a solution has been found
     int W, n;
     ifs >> W >> n;
 
@@ -89,7 +168,7 @@ int read_input_file(const string &filename)
             // Add 'count' number of rectangles with dimensions rw x rh
             for (int i = 0; i < count; ++i)
             {
-                rectangles.emplace_back(Rectangle{rw, rh, false});
+                rectangles.emplace_back(Rectangle{rw, rh});
             }
         }
         else
@@ -101,146 +180,50 @@ int read_input_file(const string &filename)
     return W;
 }
 
-// Places a rectangle in the solution and updates the variables
-void place_rectangle(int &width_occupied,
-                     int &width_remaining,
-                     int &previous_height,
-                     int W,
-                     int x,
-                     int y,
-                     Rectangle &r,
-                     vector<Solution> &solutions,
-                     bool first_in_row)
-{
-    solutions.push_back({x, y, x + r.width - 1, y + r.height - 1});
-    r.placed = true;
-    if (first_in_row)
-    {
-        width_occupied = r.width;
-        previous_height = r.height;
-        width_remaining = W - width_occupied;
-    }
-    else
-    {
-        width_occupied += r.width;
-        width_remaining = W - width_occupied;
-    }
-}
-
-// Builds a single solution row by row
-int grasp(vector<Rectangle> &rects,
-          vector<Solution> &solutions,
-          int &roll_length,
-          int W,
-          int &width_occupied,
-          int &width_remaining,
-          int &previous_height)
-{
-    for (auto &big : rects)
-    {
-        if (!big.placed)
-        {
-            int x = 0, y = roll_length;
-            bool placed_big = false;
-
-            // Try the two orientations for the "big" rectangle
-            for (int rot = 0; rot < 2 && !placed_big; ++rot)
-            {
-                swap(big.width, big.height);
-                if (big.width <= W)
-                {
-                    place_rectangle(width_occupied,
-                                    width_remaining,
-                                    previous_height,
-                                    W,
-                                    x, y,
-                                    big,
-                                    solutions,
-                                    true);
-                    roll_length += big.height;
-                    placed_big = true;
-                }
-            }
-
-            // Fill leftover space if big rectangle was placed
-            if (placed_big)
-            {
-                bool row_full = false;
-                for (auto &small : rects)
-                {
-                    if (!small.placed && !row_full)
-                    {
-                        x = width_occupied;
-                        bool placed_small = false;
-                        // Rotate the small rectangle
-                        for (int rot = 0; rot < 2 && !placed_small; ++rot)
-                        {
-                            swap(small.width, small.height);
-                            if (small.width <= width_remaining && small.height <= previous_height)
-                            {
-                                place_rectangle(width_occupied,
-                                                width_remaining,
-                                                previous_height,
-                                                W,
-                                                x, y,
-                                                small,
-                                                solutions,
-                                                false);
-                                placed_small = true;
-                            }
-                        }
-                        // If leftover space is fully occupied, mark it
-                        if (width_occupied == W)
-                        {
-                            row_full = true;
-                        }
-                    }
-                }
-            }
-        }
-    }
-    return roll_length;
-}
-
-// Tries random permutations to find better solutions
+// Tries random permutations to find better solutions (GraspSearch, see grasp_search.h)
 void vns_search(int iterations, int W)
 {
-    // Random number generator
-    random_device rd;
-    mt19937 g(rd());
+    GraspSearch grasp(W, piece_dimensions(), random_device{}());
+    if (incumbent().length < INT_MAX)
+        grasp.set_incumbent(incumbent().length, incumbent_placements());
+
+#ifdef COUNT_ALLOCATIONS
+    long long allocations_before = heap_allocations;
+#endif
 
     for (int i = 0; i < iterations; ++i)
     {
-        // Shuffle rectangles
-        shuffle(rectangles.begin(), rectangles.end(), g);
+        if (!grasp.iterate())
+            continue;
+        take_incumbent(grasp.best_length, grasp.best);
 
-        // Reset all parameters
-        for (auto &r : rectangles)
-        {
-            r.placed = false;
-        }
+        // A solution at the lower bound is optimal
+        if (incumbent().length <= length_lower_bound)
+            break;
+    }
 
-        int width_occupied_local = 0;
-        int width_remaining_local = W;
-        int previous_height_local = 0;
+#ifdef COUNT_ALLOCATIONS
+    cerr << "Heap allocations during search: " << heap_allocations - allocations_before << endl;
+#endif
+}
 
-        vector<Solution> candidate;
-        int roll_length = 0;
+// Large-neighbourhood search (--lns): bands of the incumbent are re-packed exactly (see lns_search.h)
+const double LNS_TIME_LIMIT = 55.0; // Seconds of CPU time after which the LNS stops
 
-        int new_length = grasp(rectangles,
-                               candidate,
-                               roll_length,
-                               W,
-                               width_occupied_local,
-                               width_remaining_local,
-                               previous_height_local);
+void lns_search(int W)
+{
+    LnsSearch lns(W, incumbent_placements(), incumbent().length, length_lower_bound, random_device{}());
+    int improvements = 0;
 
-        if (new_length < best_length)
-        {
-            best_length = new_length;
-            best_solution = candidate;
-        }
+    while (!lns.done() && double(clock() - start_time) / CLOCKS_PER_SEC < LNS_TIME_LIMIT)
+    {
+        if (!lns.step())
+            continue;
+        take_incumbent(lns.length, lns.layout);
+        ++improvements;
     }
+
+    cerr << "LNS improvements: " << improvements << endl;
 }
 
 // Sort rectangles by descending area
@@ -257,18 +240,42 @@ int main(int argc, char *argv[])
 
     if (argc < 3)
     {
-        cerr << "Usage: " << argv[0] << " <input_file> <output_file>" << endl;
+        cerr << "Usage: " << argv[0] << " <input_file> <output_file> [--lns]" << endl;
         return 1;
     }
     output_filename = argv[2];
 
+    // With --lns, the best layout of the GRASP is improved by large-neighbourhood search
+    bool lns = argc > 3 && string(argv[3]) == "--lns";
+
     // Read roll width
     int W = read_input_file(argv[1]);
 
     sort(rectangles.begin(), rectangles.end(), compare_rectangles);
 
-    vns_search(600000, W);
+    roll_width = W;
+    for (auto &snapshot : snapshots)
+        snapshot.placements.reset(rectangles.size());
+
+    // LP lower bound on the roll length, to stop early on an optimal solution and report the gap
+    length_lower_bound = strip_lower_bound(W, piece_dimensions());
+
+    // A cached layout of the same order is the starting incumbent; a proven one is returned right away
+    CachedLayout cached;
+    if (load_cached_layout(W, piece_dimensions(), cached))
+        take_incumbent(cached.length, cached.placements);
+
+    if (cached.proven || incumbent().length <= length_lower_bound)
+        cerr << "Proven layout found in the layout cache" << endl;
+    else
+    {
+        vns_search(600000, W);
+        if (lns && incumbent().length < INT_MAX)
+            lns_search(W);
+    }
 
     write_solution();
+    update_cache();
+    report_gap();
     return 0;
 }
@@ -0,0 +1,188 @@
+#ifndef PROPAGATION_H
+#define PROPAGATION_H
+
+#include <algorithm>
+#include <climits>
+#include <utility>
+#include <vector>
+
+#include "roll_grid.h"
+
+// Node propagation of the exhaustive search, shared by exhaustive_search.h and lns_search.h.
+//
+// The pieces are given in placement order; at a node where pieces[0..index)
+// are placed and the layout is current_length long, feasible() checks whether
+// any completion can still beat the incumbent:
+//  - energetic area bound: the remaining area must fit in the rows below it;
+//  - wasted space: a free cell only counts if some remaining piece can cover it;
+//  - pieces wider than W / 2 can never share a row, so they need wide rows;
+//  - gap dominance: a piece too long for the empty rows needs an existing gap.
+// Suffix data is precomputed once and the scratch tables are reused, so a
+// call never allocates.
+
+struct Propagator
+{
+    int W = 0;
+    int grid_height = 0;
+    std::vector<std::pair<int, int>> pieces; // (width, height) in placement order
+    std::vector<long long> suffix_area;      // Total area of pieces[index..]
+    std::vector<int> suffix_min_side;        // Smallest short side among pieces[index..]
+    std::vector<int> suffix_min_long;        // Smallest long side among pieces[index..]
+    long long total_area = 0;                // Total area of all pieces
+    std::vector<int> free_down;              // Scratch: free run from (x, y) downwards, indexed x * grid_height + y
+    std::vector<int> free_vertical;          // Scratch: length of the vertical free segment containing (x, y)
+    std::vector<int> free_horizontal;        // Scratch: length of the horizontal free segment containing (x, y)
+
+    Propagator() = default;
+
+    // height is the number of rows of the grids passed to feasible()
+    Propagator(int roll_width, const std::vector<std::pair<int, int>> &placement_order, int height)
+        : W(roll_width), grid_height(height), pieces(placement_order)
+    {
+        int n = static_cast<int>(pieces.size());
+        suffix_area.assign(n + 1, 0);
+        suffix_min_side.assign(n + 1, INT_MAX);
+        suffix_min_long.assign(n + 1, INT_MAX);
+        for (int i = n - 1; i >= 0; --i)
+        {
+            int w = pieces[i].first, h = pieces[i].second;
+            suffix_area[i] = suffix_area[i + 1] + static_cast<long long>(w) * h;
+            suffix_min_side[i] = std::min(suffix_min_side[i + 1], std::min(w, h));
+            suffix_min_long[i] = std::min(suffix_min_long[i + 1], std::max(w, h));
+        }
+        total_area = suffix_area[0];
+
+        free_down.assign(static_cast<size_t>(W) * grid_height, 0);
+        free_vertical.assign(static_cast<size_t>(W) * grid_height, 0);
+        free_horizontal.assign(static_cast<size_t>(W) * grid_height, 0);
+    }
+
+    // Checks whether a rectangle fits with its top row in [0, current_length) using the free_down table.
+    bool fits_somewhere(int width, int height, int current_length) const
+    {
+        if (width > W)
+            return false;
+
+        for (int y = 0; y < current_length; ++y)
+        {
+            int consecutive = 0;
+            for (int x = 0; x < W; ++x)
+            {
+                consecutive = free_down[x * grid_height + y] >= height ? consecutive + 1 : 0;
+                if (consecutive == width)
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    // Returns false if no completion of the partial layout can be shorter than best_length
+    // (INT_MAX if there is no incumbent yet).
+    template <typename Grid>
+    bool feasible(int index, int current_length, const Grid &grid, int best_length)
+    {
+        int limit = best_length == INT_MAX ? grid_height : std::min(best_length - 1, grid_height);
+        long long remaining_area = suffix_area[index];
+        long long placed_area = total_area - remaining_area;
+
+        // Energetic reasoning on the x-projection: the roll is a resource of capacity W over
+        // the rows [0, limit), and the remaining rectangles must fit in what is left of it
+        if (remaining_area > static_cast<long long>(W) * limit - placed_area)
+            return false;
+
+        // Rows [current_length, limit) are empty, so only the rows below current_length are scanned.
+        // Free runs of every cell there, vertically (bounded by limit) and horizontally
+        int min_side = suffix_min_side[index];
+        int min_long = suffix_min_long[index];
+        int empty_rows = limit - current_length;
+        int wide_rows = empty_rows; // Rows with a horizontal free segment longer than W / 2
+        long long usable_area = 0;
+
+        for (int x = 0; x < W; ++x)
+        {
+            int *down = &free_down[x * grid_height];
+            int *vertical = &free_vertical[x * grid_height];
+            int run = empty_rows;
+            for (int y = current_length - 1; y >= 0; --y)
+            {
+                run = is_occupied(grid, x, y) ? 0 : run + 1;
+                down[y] = run;
+            }
+            for (int y = 0; y < current_length; ++y)
+                vertical[y] = (y == 0 || is_occupied(grid, x, y - 1)) ? down[y] : vertical[y - 1];
+
+            // Cells of the empty rows span the whole width and the top free segment of the column
+            int top_segment = current_length > 0 && !is_occupied(grid, x, current_length - 1)
+                                  ? vertical[current_length - 1]
+                                  : empty_rows;
+            if (std::min(top_segment, W) >= min_side && std::max(top_segment, W) >= min_long)
+                usable_area += empty_rows;
+        }
+
+        for (int y = 0; y < current_length; ++y)
+        {
+            int x = 0, widest = 0;
+            while (x < W)
+            {
+                if (is_occupied(grid, x, y))
+                {
+                    ++x;
+                    continue;
+                }
+                int start = x;
+                while (x < W && !is_occupied(grid, x, y))
+                    ++x;
+                for (int i = start; i < x; ++i)
+                    free_horizontal[i * grid_height + y] = x - start;
+                widest = std::max(widest, x - start);
+            }
+            if (2 * widest > W)
+                ++wide_rows;
+
+            // Wasted space: a free cell is only usable if some remaining rectangle can cover it
+            for (int i = 0; i < W; ++i)
+            {
+                if (is_occupied(grid, i, y))
+                    continue;
+                int v = free_vertical[i * grid_height + y];
+                int h = free_horizontal[i * grid_height + y];
+                if (std::min(v, h) >= min_side && std::max(v, h) >= min_long)
+                    ++usable_area;
+            }
+        }
+
+        if (remaining_area > usable_area)
+            return false;
+
+        // Rectangles wider than W / 2 in both orientations can never share a row,
+        // so together they need at least the sum of their lengths in wide rows
+        int n = static_cast<int>(pieces.size());
+        long long wide_length = 0;
+        for (int i = index; i < n; ++i)
+        {
+            int short_side = std::min(pieces[i].first, pieces[i].second);
+            int long_side = std::max(pieces[i].first, pieces[i].second);
+            if (2 * short_side > W)
+                wide_length += long_side > W ? long_side : short_side;
+        }
+        if (wide_length > wide_rows)
+            return false;
+
+        // Dominance on gaps: a rectangle that no longer fits above current_length can
+        // only go into an existing gap, so at least one such gap must exist for it
+        for (int i = index; i < n; ++i)
+        {
+            int w = pieces[i].first, h = pieces[i].second;
+            if (i > index && pieces[i] == pieces[i - 1])
+                continue;
+
+            int room = limit - current_length;
+            bool above = (w <= W && h <= room) || (h <= W && w <= room);
+            if (!above && !fits_somewhere(w, h, current_length) && !fits_somewhere(h, w, current_length))
+                return false;
+        }
+        return true;
+    }
+};
+
+#endif
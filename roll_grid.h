@@ -0,0 +1,327 @@
+#ifndef ROLL_GRID_H
+#define ROLL_GRID_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Occupancy grids of the roll, shared by the solvers.
+//
+// ColumnGrid is the generic representation (one vector<bool> per column) and
+// works for any roll width. RowGrid<WORDS> stores each row of the roll as a
+// fixed number of 64-bit words, so it only handles rolls with W <= 64 * WORDS;
+// in exchange an overlap test costs one AND per word and row. Solvers are
+// written as templates over the grid type and pick the narrowest RowGrid that
+// fits W at startup (see dispatch_on_width).
+
+// Generic grid: cells[x][y] is true if the cell is occupied.
+struct ColumnGrid
+{
+    int width, height;
+    std::vector<std::vector<bool>> cells;
+
+    ColumnGrid(int w, int h) : width(w), height(h), cells(w, std::vector<bool>(h, false)) {}
+};
+
+// Narrow-roll grid: bit x of rows[y] is set if the cell (x, y) is occupied.
+template <int WORDS>
+struct RowGrid
+{
+    using Row = std::array<uint64_t, WORDS>;
+
+    int width, height;
+    std::vector<Row> rows;
+
+    RowGrid(int w, int h) : width(w), height(h), rows(h, Row{}) {}
+};
+
+inline bool is_occupied(const ColumnGrid &grid, int x, int y)
+{
+    return grid.cells[x][y];
+}
+
+template <int WORDS>
+inline bool is_occupied(const RowGrid<WORDS> &grid, int x, int y)
+{
+    return (grid.rows[y][x >> 6] >> (x & 63)) & 1;
+}
+
+// Marks every cell as unoccupied, so a grid can be reused for another layout.
+inline void clear_grid(ColumnGrid &grid)
+{
+    for (auto &column : grid.cells)
+        column.assign(grid.height, false);
+}
+
+template <int WORDS>
+inline void clear_grid(RowGrid<WORDS> &grid)
+{
+    grid.rows.assign(grid.height, typename RowGrid<WORDS>::Row{});
+}
+
+// Copies rows [0, rows) of src into dst (grids of the same width), leaving the other rows of dst as they are.
+inline void copy_rows(ColumnGrid &dst, const ColumnGrid &src, int rows)
+{
+    for (int x = 0; x < src.width; ++x)
+        std::copy(src.cells[x].begin(), src.cells[x].begin() + rows, dst.cells[x].begin());
+}
+
+template <int WORDS>
+inline void copy_rows(RowGrid<WORDS> &dst, const RowGrid<WORDS> &src, int rows)
+{
+    std::copy(src.rows.begin(), src.rows.begin() + rows, dst.rows.begin());
+}
+
+// Check if a width x height rectangle can be placed at position (x, y).
+inline bool can_place(const ColumnGrid &grid, int x, int y, int width, int height)
+{
+    if (x + width > grid.width || y + height > grid.height)
+        return false;
+
+    for (int i = x; i < x + width; ++i)
+    {
+        for (int j = y; j < y + height; ++j)
+        {
+            if (grid.cells[i][j])
+                return false;
+        }
+    }
+    return true;
+}
+
+// Marks or unmarks the cells occupied by the rectangle.
+inline void place_or_remove(ColumnGrid &grid, int x, int y, int width, int height, bool action)
+{
+    for (int i = x; i < x + width; ++i)
+    {
+        for (int j = y; j < y + height; ++j)
+        {
+            grid.cells[i][j] = action;
+        }
+    }
+}
+
+// Mask selecting columns [x, x + width) of a row.
+template <int WORDS>
+inline typename RowGrid<WORDS>::Row row_mask(int x, int width)
+{
+    typename RowGrid<WORDS>::Row mask{};
+    for (int k = 0; k < WORDS; ++k)
+    {
+        int lo = x - 64 * k, hi = x + width - 64 * k;
+        if (hi <= 0 || lo >= 64)
+            continue;
+        lo = lo < 0 ? 0 : lo;
+        hi = hi > 64 ? 64 : hi;
+        uint64_t upto_hi = hi == 64 ? ~uint64_t(0) : (uint64_t(1) << hi) - 1;
+        mask[k] = upto_hi & ~((uint64_t(1) << lo) - 1);
+    }
+    return mask;
+}
+
+template <int WORDS>
+inline bool can_place(const RowGrid<WORDS> &grid, int x, int y, int width, int height)
+{
+    if (x + width > grid.width || y + height > grid.height)
+        return false;
+
+    const auto mask = row_mask<WORDS>(x, width);
+    for (int j = y; j < y + height; ++j)
+    {
+        uint64_t overlap = 0;
+        for (int k = 0; k < WORDS; ++k)
+            overlap |= grid.rows[j][k] & mask[k];
+        if (overlap)
+            return false;
+    }
+    return true;
+}
+
+template <int WORDS>
+inline void place_or_remove(RowGrid<WORDS> &grid, int x, int y, int width, int height, bool action)
+{
+    const auto mask = row_mask<WORDS>(x, width);
+    for (int j = y; j < y + height; ++j)
+    {
+        for (int k = 0; k < WORDS; ++k)
+        {
+            if (action)
+                grid.rows[j][k] |= mask[k];
+            else
+                grid.rows[j][k] &= ~mask[k];
+        }
+    }
+}
+
+// Lowest x at which a width x height rectangle can be placed with its top row at y, or -1.
+inline int first_fit_x(const ColumnGrid &grid, int y, int width, int height)
+{
+    for (int x = 0; x + width <= grid.width; ++x)
+    {
+        if (can_place(grid, x, y, width, height))
+            return x;
+    }
+    return -1;
+}
+
+// Shifts a multi-word row right by k bits (towards lower columns).
+template <int WORDS>
+inline typename RowGrid<WORDS>::Row shift_right(const typename RowGrid<WORDS>::Row &row, int k)
+{
+    typename RowGrid<WORDS>::Row out{};
+    int words = k >> 6, bits = k & 63;
+    for (int i = 0; i + words < WORDS; ++i)
+    {
+        out[i] = row[i + words] >> bits;
+        if (bits && i + words + 1 < WORDS)
+            out[i] |= row[i + words + 1] << (64 - bits);
+    }
+    return out;
+}
+
+// Keeps only the columns of free that start a run of width free columns, doubling the run each step.
+template <int WORDS>
+inline typename RowGrid<WORDS>::Row run_starts(typename RowGrid<WORDS>::Row free, int width)
+{
+    for (int covered = 1; covered < width;)
+    {
+        int step = covered < width - covered ? covered : width - covered;
+        const auto shifted = shift_right<WORDS>(free, step);
+        for (int k = 0; k < WORDS; ++k)
+            free[k] &= shifted[k];
+        covered += step;
+    }
+    return free;
+}
+
+// Columns x at which a width x height rectangle fits with its top row at y (bit x set).
+// The caller checks that y + height <= grid.height and width <= grid.width.
+template <int WORDS>
+inline typename RowGrid<WORDS>::Row fit_columns(const RowGrid<WORDS> &grid, int y, int width, int height)
+{
+    // Bit x of fit is set if column x is free in every row of [y, y + height)
+    typename RowGrid<WORDS>::Row fit = row_mask<WORDS>(0, grid.width);
+    for (int j = y; j < y + height; ++j)
+    {
+        for (int k = 0; k < WORDS; ++k)
+            fit[k] &= ~grid.rows[j][k];
+    }
+
+    return run_starts<WORDS>(fit, width);
+}
+
+template <int WORDS>
+inline int first_fit_x(const RowGrid<WORDS> &grid, int y, int width, int height)
+{
+    if (width > grid.width || y + height > grid.height)
+        return -1;
+
+    const auto fit = fit_columns<WORDS>(grid, y, width, height);
+    for (int k = 0; k < WORDS; ++k)
+    {
+        if (fit[k])
+            return 64 * k + __builtin_ctzll(fit[k]);
+    }
+    return -1;
+}
+
+// For every x in [0, grid.width - width], stores in lowest[x] the lowest y <= max_y at which a
+// width x height rectangle can be placed in column x, or -1 if there is none.
+inline void lowest_fit_rows(const ColumnGrid &grid, int width, int height, int max_y, int *lowest)
+{
+    for (int x = 0; x + width <= grid.width; ++x)
+    {
+        lowest[x] = -1;
+        for (int y = 0; y <= max_y; ++y)
+        {
+            if (can_place(grid, x, y, width, height))
+            {
+                lowest[x] = y;
+                break;
+            }
+        }
+    }
+}
+
+template <int WORDS>
+inline void lowest_fit_rows(const RowGrid<WORDS> &grid, int width, int height, int max_y, int *lowest)
+{
+    if (width > grid.width)
+        return;
+
+    // Columns still waiting for their lowest row
+    typename RowGrid<WORDS>::Row pending = row_mask<WORDS>(0, grid.width - width + 1);
+    for (int x = 0; x + width <= grid.width; ++x)
+        lowest[x] = -1;
+
+    for (int y = 0; y <= max_y && y + height <= grid.height; ++y)
+    {
+        // Rows of the window are added from the bottom up. Once no pending column starts a
+        // free run of rows [j, y + height), no window starting in [y, j] can hold the
+        // rectangle in a pending column either, so the scan resumes at row j + 1
+        typename RowGrid<WORDS>::Row free = row_mask<WORDS>(0, grid.width), fit;
+        int j = y + height - 1;
+        for (; j >= y; --j)
+        {
+            uint64_t any_fit = 0;
+            for (int k = 0; k < WORDS; ++k)
+                free[k] &= ~grid.rows[j][k];
+            fit = run_starts<WORDS>(free, width);
+            for (int k = 0; k < WORDS; ++k)
+                any_fit |= fit[k] & pending[k];
+            if (!any_fit)
+                break;
+        }
+        if (j >= y)
+        {
+            y = j;
+            continue;
+        }
+
+        uint64_t any_pending = 0;
+        for (int k = 0; k < WORDS; ++k)
+        {
+            uint64_t found = fit[k] & pending[k];
+            pending[k] &= ~found;
+            any_pending |= pending[k];
+            for (; found; found &= found - 1)
+                lowest[64 * k + __builtin_ctzll(found)] = y;
+        }
+        if (!any_pending)
+            return;
+    }
+}
+
+// Upper bound on the roll length, used as the grid height: every piece (width, height)
+// stacked with its long side vertical.
+inline int max_roll_length(const std::vector<std::pair<int, int>> &pieces)
+{
+    int max_dim = 0;
+    for (const auto &p : pieces)
+        max_dim += std::max(p.first, p.second);
+    return max_dim;
+}
+
+// Tag carrying a grid type through a generic lambda.
+template <typename Grid>
+struct GridType
+{
+    using type = Grid;
+};
+
+// Calls solve(GridType<Grid>{}) with the narrowest grid type that fits a roll of width W.
+template <typename Solve>
+inline auto dispatch_on_width(int W, Solve &&solve)
+{
+    if (W <= 64)
+        return solve(GridType<RowGrid<1>>{});
+    if (W <= 128)
+        return solve(GridType<RowGrid<2>>{});
+    if (W <= 256)
+        return solve(GridType<RowGrid<4>>{});
+    return solve(GridType<ColumnGrid>{});
+}
+
+#endif
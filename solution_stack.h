@@ -0,0 +1,55 @@
+#ifndef SOLUTION_STACK_H
+#define SOLUTION_STACK_H
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+// Fixed-capacity stack of placements used by the search hot loops.
+// Storage is allocated once (constructor or reset) and every search owns its
+// own stacks, so push_back/pop_back never touch the heap. Incumbent snapshots
+// are taken either with copy_from, which reuses the destination's storage, or
+// by filling a second stack and switching an index to it; the index switch is
+// what a signal handler reading the incumbent needs, since swapping two stacks
+// briefly leaves one of them empty.
+template <typename T>
+struct SolutionStack
+{
+    std::vector<T> slots; // Preallocated storage, slots.size() is the capacity
+    std::size_t count = 0; // Number of elements in use
+
+    SolutionStack() = default;
+    explicit SolutionStack(std::size_t capacity) : slots(capacity) {}
+
+    // Sets the capacity and empties the stack (this is the only call that may allocate)
+    void reset(std::size_t capacity)
+    {
+        slots.resize(capacity);
+        count = 0;
+    }
+
+    void push_back(const T &value) { slots[count++] = value; }
+    void pop_back() { --count; }
+    void clear() { count = 0; }
+
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    std::size_t capacity() const { return slots.size(); }
+
+    T &operator[](std::size_t i) { return slots[i]; }
+    const T &operator[](std::size_t i) const { return slots[i]; }
+
+    T *begin() { return slots.data(); }
+    T *end() { return slots.data() + count; }
+    const T *begin() const { return slots.data(); }
+    const T *end() const { return slots.data() + count; }
+
+    // Copies the contents of other into this stack's storage (capacities must match)
+    void copy_from(const SolutionStack &other)
+    {
+        std::copy(other.begin(), other.end(), slots.begin());
+        count = other.count;
+    }
+};
+
+#endif
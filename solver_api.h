@@ -0,0 +1,418 @@
+#ifndef SOLVER_API_H
+#define SOLVER_API_H
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <climits>
+#include <coroutine>
+#include <exception>
+#include <stdexcept>
+#include <stop_token>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "exhaustive_search.h"
+#include "grasp_search.h"
+#include "greedy_placement.h"
+#include "layout_cache.h"
+#include "lns_search.h"
+#include "lower_bound.h"
+#include "roll_grid.h"
+
+// Embeddable solver API (C++20, header-only).
+//
+// Each strategy is a coroutine that yields every improved layout as soon as it
+// is found, so a caller can multiplex many solves in one process and stop
+// reading whenever the current incumbent is good enough:
+//
+//     SolveOptions options;
+//     options.deadline = chrono::steady_clock::now() + chrono::seconds(2);
+//     options.stop = stop_source.get_token();
+//     for (const Layout &layout : textile::exhaustive_layouts(W, pieces, options))
+//         publish(layout); // Each one is shorter than the previous
+//
+// The strategies run the code of the binaries, from the shared headers:
+// exhaustive_layouts is exh's branch and bound (exhaustive_search.h, with its
+// checkpoint files), grasp_layouts is mh's randomised row construction and
+// optional LNS (grasp_search.h, lns_search.h), and greedy_layouts is greedy's
+// placement, rule portfolio and beam search (greedy_placement.h). Instead of a
+// signal handler that writes the incumbent and exits, they check the stop token
+// and the deadline cooperatively and simply finish: the last layout yielded is
+// the best one found. A layout is yielded with proven set only if it reaches
+// the lower bound. Completing the exhaustive search proves nothing, because
+// its branching (fixed area order, lowest free y per column) does not cover
+// every layout. With use_cache, a cached layout of the same order is yielded
+// first and is the incumbent to beat, and every improvement is written back.
+// Errors (a checkpoint of another instance, for example) are thrown from the
+// generator's iteration.
+//
+// pieces holds the (width, height) of every rectangle; placements are returned
+// as x1 y1 x2 y2 (inclusive corners), as in the solvers' output files.
+
+namespace textile
+{
+
+// Layouts use the representation of the layout cache, so they can be stored as is
+using Layout = CachedLayout;
+
+struct SolveOptions
+{
+    std::stop_token stop; // Cooperative cancellation (default: never requested)
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    bool use_cache = false;              // Read and update the layout cache (see layout_cache.h)
+    std::string checkpoint_file;         // exhaustive_layouts: resume from and save the search frontier (exh's format)
+    unsigned seed = 0;                   // Seed of the randomised strategies
+    long long grasp_iterations = 600000; // Permutations tried by grasp_layouts
+    bool lns = false;                    // grasp_layouts: then improve the best layout by LNS (mh --lns)
+    bool portfolio = false;              // greedy_layouts: try every sort and placement rule (greedy --portfolio)
+    int beam_width = 0;                  // greedy_layouts: then run a beam search of this width (greedy's beam_width)
+    int threads = 1;                     // Threads of the beam search
+
+    bool should_stop() const
+    {
+        return stop.stop_requested() ||
+               (deadline != std::chrono::steady_clock::time_point::max() &&
+                std::chrono::steady_clock::now() >= deadline);
+    }
+};
+
+// Lazily evaluated sequence of values produced by a coroutine (single pass)
+template <typename T>
+class Generator
+{
+public:
+    struct promise_type
+    {
+        const T *current = nullptr;
+        std::exception_ptr error;
+
+        Generator get_return_object() { return Generator(Handle::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        std::suspend_always yield_value(const T &value) noexcept
+        {
+            current = &value;
+            return {};
+        }
+        void return_void() {}
+        void unhandled_exception() { error = std::current_exception(); }
+    };
+
+    using Handle = std::coroutine_handle<promise_type>;
+
+    struct Sentinel
+    {
+    };
+
+    class Iterator
+    {
+    public:
+        explicit Iterator(Handle handle) : handle_(handle) {}
+
+        const T &operator*() const { return *handle_.promise().current; }
+        const T *operator->() const { return handle_.promise().current; }
+        Iterator &operator++()
+        {
+            resume(handle_);
+            return *this;
+        }
+        bool operator==(Sentinel) const { return handle_.done(); }
+
+    private:
+        Handle handle_;
+    };
+
+    Generator(Generator &&other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    Generator &operator=(Generator &&other) noexcept
+    {
+        if (this != &other)
+        {
+            if (handle_)
+                handle_.destroy();
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+    Generator(const Generator &) = delete;
+    Generator &operator=(const Generator &) = delete;
+    ~Generator()
+    {
+        if (handle_)
+            handle_.destroy();
+    }
+
+    Iterator begin()
+    {
+        resume(handle_);
+        return Iterator(handle_);
+    }
+    Sentinel end() { return {}; }
+
+private:
+    explicit Generator(Handle handle) : handle_(handle) {}
+
+    // Runs the coroutine to its next yield, rethrowing any exception it raised
+    static void resume(Handle handle)
+    {
+        handle.resume();
+        if (handle.done() && handle.promise().error)
+            std::rethrow_exception(handle.promise().error);
+    }
+
+    Handle handle_;
+};
+
+namespace detail
+{
+
+// Sorts the pieces by descending area, the placement order of every strategy
+inline std::vector<std::pair<int, int>> by_descending_area(std::vector<std::pair<int, int>> pieces)
+{
+    std::sort(pieces.begin(), pieces.end(), sort_by_area);
+    return pieces;
+}
+
+// Lower bound used to recognise optimal layouts; the column generation is kept short
+// (as in greedy) so that starting a solve stays cheap
+inline int quick_lower_bound(int W, const std::vector<std::pair<int, int>> &pieces)
+{
+    return StripLowerBound(W, pieces).solve(500);
+}
+
+// Incumbent of a solve: the layout last yielded. With use_cache, it starts from the cached
+// layout of the order and is written back when the solve ends, even if the caller drops the
+// generator before its end.
+class Incumbent
+{
+public:
+    Layout layout;
+
+    Incumbent(int W, const std::vector<std::pair<int, int>> &pieces, int lower_bound, bool use_cache)
+        : W_(W), pieces_(pieces), lower_bound_(lower_bound), use_cache_(use_cache)
+    {
+        if (use_cache_ && load_cached_layout(W_, pieces_, layout))
+            layout.proven = layout.proven || layout.length <= lower_bound_;
+        else
+            layout = Layout{INT_MAX, false, {}};
+    }
+
+    ~Incumbent()
+    {
+        if (improved_)
+            store_cached_layout(W_, pieces_, layout);
+    }
+
+    bool empty() const { return layout.length == INT_MAX; }
+
+    // Takes a layout if it is shorter, and tells whether it did
+    bool improve(int length, const std::vector<std::array<int, 4>> &placements)
+    {
+        if (length >= layout.length)
+            return false;
+        layout.length = length;
+        layout.proven = length <= lower_bound_;
+        layout.placements = placements;
+        improved_ = use_cache_;
+        return true;
+    }
+
+private:
+    int W_;
+    const std::vector<std::pair<int, int>> &pieces_;
+    int lower_bound_;
+    bool use_cache_;
+    bool improved_ = false; // Shorter than the cached layout, to be written back
+};
+
+// Branch and bound of exh (see exhaustive_search.h). With a checkpoint file, the search
+// resumes from it and saves its frontier there whenever the generator stops or is destroyed.
+template <typename Grid>
+Generator<Layout> exhaustive_search(int W, std::vector<std::pair<int, int>> pieces, SolveOptions options)
+{
+    pieces = by_descending_area(std::move(pieces));
+    int lower_bound = quick_lower_bound(W, pieces);
+    if (lower_bound == INT_MAX)
+        co_return; // Some piece is wider than the roll
+
+    Incumbent incumbent(W, pieces, lower_bound, options.use_cache);
+    if (!incumbent.empty())
+    {
+        co_yield incumbent.layout;
+        if (incumbent.layout.proven)
+            co_return;
+    }
+
+    ExhaustiveSearch<Grid> search(W, pieces, lower_bound);
+    auto start = std::chrono::steady_clock::now();
+    double resumed_elapsed = 0;
+    bool finished = false;
+    if (!options.checkpoint_file.empty())
+    {
+        switch (load_checkpoint(options.checkpoint_file, search, resumed_elapsed))
+        {
+        case CheckpointLoad::MISMATCH:
+            throw std::runtime_error("checkpoint file " + options.checkpoint_file + " does not match the input");
+        case CheckpointLoad::INVALID:
+            throw std::runtime_error("cannot parse checkpoint file " + options.checkpoint_file);
+        case CheckpointLoad::FINISHED:
+            finished = true;
+            break;
+        default:
+            break;
+        }
+        if (incumbent.improve(search.best_length, search.best))
+            co_yield incumbent.layout;
+        if (finished)
+            co_return;
+    }
+    if (!incumbent.empty())
+        search.set_incumbent(incumbent.layout.length, incumbent.layout.placements);
+
+    // Saves the frontier when the coroutine ends, including when the caller drops the generator
+    struct CheckpointOnExit
+    {
+        const SolveOptions &options;
+        const ExhaustiveFrontier &search;
+        std::chrono::steady_clock::time_point start;
+        double resumed_elapsed;
+        const bool &finished;
+
+        ~CheckpointOnExit()
+        {
+            if (!options.checkpoint_file.empty())
+                save_checkpoint(options.checkpoint_file, search,
+                                resumed_elapsed + std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(),
+                                finished);
+        }
+    } checkpoint_on_exit{options, search, start, resumed_elapsed, finished};
+
+    // Checked at every node: reading the clock is cheap next to the propagation,
+    // and a deep dive on a wide roll can take long before the first leaf
+    auto should_stop = [&options]()
+    { return options.should_stop(); };
+    for (;;)
+    {
+        auto status = search.run(should_stop);
+        if (status == ExhaustiveSearch<Grid>::PAUSED)
+            co_return;
+        if (status == ExhaustiveSearch<Grid>::FINISHED)
+        {
+            finished = true;
+            co_return;
+        }
+        if (incumbent.improve(search.best_length, search.best))
+            co_yield incumbent.layout;
+    }
+}
+
+// Placements of greedy (see greedy_placement.h): the default greedy, then the other rules of
+// the portfolio in turn and the beam search if they are enabled
+template <typename Grid>
+Generator<Layout> greedy_search(int W, std::vector<std::pair<int, int>> pieces, SolveOptions options)
+{
+    pieces = by_descending_area(std::move(pieces));
+    int lower_bound = quick_lower_bound(W, pieces);
+    if (lower_bound == INT_MAX)
+        co_return; // Some piece is wider than the roll
+
+    Incumbent incumbent(W, pieces, lower_bound, options.use_cache);
+    if (!incumbent.empty())
+    {
+        co_yield incumbent.layout;
+        if (incumbent.layout.proven)
+            co_return;
+    }
+
+    auto should_stop = [&options]()
+    { return options.should_stop(); };
+    Grid grid(W, max_roll_length(pieces));
+    std::vector<std::pair<int, int>> order;
+    std::vector<std::array<int, 4>> solution;
+    for (int job = 0; job < (options.portfolio ? PORTFOLIO_JOBS : 1); ++job)
+    {
+        int length = do_portfolio_job(grid, pieces, job, order, solution, should_stop);
+        if (length == -1)
+            co_return;
+        if (incumbent.improve(length, solution))
+        {
+            co_yield incumbent.layout;
+            if (incumbent.layout.proven)
+                co_return;
+        }
+    }
+
+    if (options.beam_width > 0)
+    {
+        int length = do_beam_placement<Grid>(W, pieces, solution, options.beam_width, std::max(options.threads, 1),
+                                             incumbent.layout.length, should_stop);
+        if (length != -1 && incumbent.improve(length, solution))
+            co_yield incumbent.layout;
+    }
+}
+
+} // namespace detail
+
+// Exhaustive branch and bound (exh): yields every improvement until the tree is explored
+inline Generator<Layout> exhaustive_layouts(int W, std::vector<std::pair<int, int>> pieces, SolveOptions options = {})
+{
+    return dispatch_on_width(W, [&](auto grid_type)
+                             { return detail::exhaustive_search<typename decltype(grid_type)::type>(W, std::move(pieces), std::move(options)); });
+}
+
+// Greedy placement (greedy): yields the default layout, then the improvements of the portfolio
+// and the beam search if they are enabled, unless stopped first
+inline Generator<Layout> greedy_layouts(int W, std::vector<std::pair<int, int>> pieces, SolveOptions options = {})
+{
+    return dispatch_on_width(W, [&](auto grid_type)
+                             { return detail::greedy_search<typename decltype(grid_type)::type>(W, std::move(pieces), std::move(options)); });
+}
+
+// Randomised row construction over shuffled orders (mh), then LNS if enabled: yields every
+// improvement until grasp_iterations orders were tried (and the LNS gave up), the lower
+// bound is reached or the search is stopped
+inline Generator<Layout> grasp_layouts(int W, std::vector<std::pair<int, int>> pieces, SolveOptions options = {})
+{
+    pieces = detail::by_descending_area(std::move(pieces));
+    int lower_bound = detail::quick_lower_bound(W, pieces);
+    if (lower_bound == INT_MAX)
+        co_return; // Some piece is wider than the roll
+
+    detail::Incumbent incumbent(W, pieces, lower_bound, options.use_cache);
+    if (!incumbent.empty())
+    {
+        co_yield incumbent.layout;
+        if (incumbent.layout.proven)
+            co_return;
+    }
+
+    GraspSearch grasp(W, pieces, options.seed);
+    if (!incumbent.empty())
+        grasp.set_incumbent(incumbent.layout.length, incumbent.layout.placements);
+    for (long long i = 0; i < options.grasp_iterations; ++i)
+    {
+        if (options.should_stop())
+            co_return;
+        if (!grasp.iterate() || !incumbent.improve(grasp.best_length, grasp.best))
+            continue;
+
+        co_yield incumbent.layout;
+        if (incumbent.layout.proven)
+            co_return;
+    }
+
+    if (!options.lns || incumbent.empty())
+        co_return;
+
+    LnsSearch lns(W, incumbent.layout.placements, incumbent.layout.length, lower_bound, options.seed);
+    while (!lns.done() && !options.should_stop())
+    {
+        if (lns.step() && incumbent.improve(lns.length, lns.layout))
+            co_yield incumbent.layout;
+    }
+}
+
+} // namespace textile
+
+#endif
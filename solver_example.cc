@@ -0,0 +1,117 @@
+// Example client of the solver API (solver_api.h): solves an input file with
+// one strategy under a time budget, reports every improved layout on stderr
+// and writes the last one in the output format of the solvers.
+//
+//     g++ -std=c++20 -O2 -pthread solver_example.cc -o solver_example
+//     ./solver_example <input_file> <output_file> [exhaustive|greedy|grasp] [seconds] [options]
+//
+// Options map to the fields of textile::SolveOptions: --cache, --checkpoint <file>,
+// --seed <n>, --lns, --portfolio, --beam <width> and --threads <n>.
+
+#include <chrono>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "solver_api.h"
+
+using namespace std;
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        cerr << "Usage: " << argv[0] << " <input_file> <output_file> [exhaustive|greedy|grasp] [seconds] [options]" << endl;
+        return 1;
+    }
+    string strategy = argc > 3 ? argv[3] : "exhaustive";
+    double seconds = argc > 4 ? stod(argv[4]) : 5.0;
+
+    textile::SolveOptions options;
+    for (int i = 5; i < argc; i++)
+    {
+        string option = argv[i];
+        bool has_value = i + 1 < argc;
+        if (option == "--cache")
+            options.use_cache = true;
+        else if (option == "--lns")
+            options.lns = true;
+        else if (option == "--portfolio")
+            options.portfolio = true;
+        else if (option == "--checkpoint" && has_value)
+            options.checkpoint_file = argv[++i];
+        else if (option == "--seed" && has_value)
+            options.seed = stoul(argv[++i]);
+        else if (option == "--beam" && has_value)
+            options.beam_width = stoi(argv[++i]);
+        else if (option == "--threads" && has_value)
+            options.threads = stoi(argv[++i]);
+        else
+        {
+            cerr << "Unknown option: " << option << endl;
+            return 1;
+        }
+    }
+
+    ifstream ifs(argv[1]);
+    if (!ifs)
+    {
+        cerr << "Error opening file: " << argv[1] << endl;
+        return 1;
+    }
+    int W, n;
+    ifs >> W >> n;
+    vector<pair<int, int>> pieces;
+    string line;
+    getline(ifs, line);
+    while (getline(ifs, line))
+    {
+        istringstream iss(line);
+        int count, rw, rh;
+        if (iss >> count >> rw >> rh)
+            pieces.insert(pieces.end(), count, {rw, rh});
+    }
+
+    auto start = chrono::steady_clock::now();
+    options.deadline = start + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(seconds));
+
+    textile::Generator<textile::Layout> layouts =
+        strategy == "greedy"  ? textile::greedy_layouts(W, pieces, options)
+        : strategy == "grasp" ? textile::grasp_layouts(W, pieces, options)
+                              : textile::exhaustive_layouts(W, pieces, options);
+
+    // Errors of the solve (e.g. a checkpoint of another instance) are thrown from the iteration
+    textile::Layout best;
+    try
+    {
+        for (const textile::Layout &layout : layouts)
+        {
+            double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            cerr << fixed << setprecision(3) << elapsed << "s: length " << layout.length
+                 << (layout.proven ? " (proven)" : "") << endl;
+            best = layout;
+        }
+    }
+    catch (const exception &error)
+    {
+        cerr << "Error: " << error.what() << endl;
+        return 1;
+    }
+    if (best.placements.empty())
+    {
+        cerr << "No layout found" << endl;
+        return 1;
+    }
+
+    ofstream out(argv[2], ios::out | ios::trunc);
+    out << fixed << setprecision(1) << chrono::duration<double>(chrono::steady_clock::now() - start).count() << "\n"
+        << best.length << "\n";
+    for (const auto &p : best.placements)
+        out << p[0] << " " << p[1] << " " << p[2] << " " << p[3] << "\n";
+    return 0;
+}